@@ -0,0 +1,13 @@
+// Compiled operators for the common FixedTypes.
+// Add this file to the build and define FIXEDPOINT_EXTERN_TEMPLATES for every
+// translation unit that includes fixed.h, see the top of fixed.h.
+#ifndef FIXEDPOINT_EXTERN_TEMPLATES
+#define FIXEDPOINT_EXTERN_TEMPLATES
+#endif
+
+#include "fixed.h"
+
+namespace FixedPoint
+{
+    FIXEDPOINT_INSTANTIATE_FIXEDTYPES(template)
+}
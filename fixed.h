@@ -2,7 +2,32 @@
 #define __FIXED_POINT__47598035
 
 #include <cstddef> // for size_t
-#include <iosfwd>
+#include <ostream>
+
+// Build with FIXEDPOINT_INSTRUMENT defined to count rescales, mixed dps
+// operations and roundings, see fixed_instrument.h
+#if defined(FIXEDPOINT_INSTRUMENT)
+#include "fixed_instrument.h"
+#define FIXEDPOINT_COUNT(op, dps1, dps2) \
+    ::FixedPoint::Instrument::count(::FixedPoint::Instrument::op, dps1, dps2)
+#define FIXEDPOINT_COUNT_IF(cond, op, dps1, dps2) \
+    ((cond) ? FIXEDPOINT_COUNT(op, dps1, dps2) : (void)0)
+#else
+#define FIXEDPOINT_COUNT(op, dps1, dps2) ((void)0)
+#define FIXEDPOINT_COUNT_IF(cond, op, dps1, dps2) ((void)0)
+#endif
+
+// The operators below forward to the entry points in details::ops, which
+// are inline and constexpr. Build the whole program, fixed.cpp included, with
+// FIXEDPOINT_EXTERN_TEMPLATES defined to make them ordinary functions; the
+// ones for the common FixedTypes pairs are then compiled once, in fixed.cpp,
+// instead of in every translation unit. Other pairs are still instantiated
+// where they are used.
+#if defined(FIXEDPOINT_EXTERN_TEMPLATES)
+#define FIXEDPOINT_ENTRY
+#else
+#define FIXEDPOINT_ENTRY inline static constexpr
+#endif
 
 // Fixed point classes
 // For storing decimal numbers with a fixed number of decimal places.
@@ -31,7 +56,7 @@ namespace FixedPoint
     namespace details
     {
         // Negative numbers crash the compiler by design
-        template<int N> struct Factor	 { enum { value = (Factor<N - 1>::value * 10) }; };
+        template<int N> struct Factor	 { enum { value = (Factor<N - 1>::value * 10LL) }; };
         template<>		struct Factor< 0>{ enum { value = 1 }; };
 
         static int RTFactor(size_t dp)
@@ -74,6 +99,25 @@ namespace FixedPoint
             struct widest {
                 typedef typename is_cond<(sizeof(T1)>sizeof(T2)), T1, T2>::type type;
             };
+
+            // Gets a type wide enough to sum many values of T
+            // Usage: wider::accumulate<T>::type
+            template<typename T>
+            struct accumulate {
+                typedef long long int type;
+            };
+
+#if defined(__SIZEOF_INT128__)
+            template<>
+            struct accumulate<long long int> {
+                typedef __int128 type;
+            };
+
+            template<>
+            struct accumulate<long int> {
+                typedef typename is_cond<(sizeof(long int) > 4), __int128, long long int>::type type;
+            };
+#endif
         }
 
         namespace ctors
@@ -84,7 +128,12 @@ namespace FixedPoint
                 inline static constexpr T1 f(const T2 in)
                 {
                     // round and scale input down
-                    return  static_cast<T1>
+                    return FIXEDPOINT_COUNT(RescaleDown, dps2, dps1),
+                        FIXEDPOINT_COUNT_IF(in % details::Factor<dps2 - dps1>::value != 0,
+                            RoundingChanged, dps2, dps1),
+                        FIXEDPOINT_COUNT_IF(!details::instrument::fits<T1>(in / details::Factor<dps2 - dps1>::value),
+                            Overflow, dps2, dps1),
+                        static_cast<T1>
                         ((in >= 0) ?
                         ((in + (details::Factor<dps2 - dps1>::value / 2)) 
                             / details::Factor<dps2 - dps1>::value)
@@ -100,14 +149,17 @@ namespace FixedPoint
             {
                 inline static constexpr T1 f(const T2 in)
                 {
-                    // scale up
-                    return static_cast<T1>
+                    // scale up, or only change type when dps1 == dps2
+                    return FIXEDPOINT_COUNT_IF(dps1 != dps2, RescaleUp, dps2, dps1),
+                        FIXEDPOINT_COUNT_IF(details::instrument::productOverflows<T1>(in, details::Factor<dps1 - dps2>::value),
+                            Overflow, dps2, dps1),
+                        static_cast<T1>
                         (in * details::Factor<dps1 - dps2>::value);
                 }
             };
 
             template <size_t dps1, size_t dps2, typename T1, typename T2>
-            inline static constexpr T1 scaleFixed(const T2 in)
+            FIXEDPOINT_ENTRY T1 scaleFixed(const T2 in)
             {
                 return scaleFixedImpl<dps1, dps2, (dps1>=dps2), T1, T2>::f(in);
             }
@@ -145,7 +197,11 @@ namespace FixedPoint
                     f(const Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b)
                 {
                     // dps1 != dps2
-                    return addImpl<dps1, dps2, (dps1 > dps2), T1, T2 > ::f(a, b);
+                    return FIXEDPOINT_COUNT(AddRescale, dps1, dps2),
+                        FIXEDPOINT_COUNT_IF((details::instrument::sumOverflows<typename details::wider::widest<T1, T2>::type>(
+                            a.m_Value, details::Factor<(dps1 > dps2 ? 0 : dps2 - dps1)>::value,
+                            b.m_Value, details::Factor<(dps1 > dps2 ? dps1 - dps2 : 0)>::value, false)), Overflow, dps1, dps2),
+                        addImpl<dps1, dps2, (dps1 > dps2), T1, T2 > ::f(a, b);
                 }
             };
 
@@ -158,12 +214,14 @@ namespace FixedPoint
                 {
                     // dps1 == dps2
                     // do work right here
-                    return a.m_Value + b.m_Value;
+                    return FIXEDPOINT_COUNT_IF((details::instrument::sumOverflows<typename details::wider::widest<T1, T2>::type>(
+                            a.m_Value, 1, b.m_Value, 1, false)), Overflow, dps1, dps2),
+                        a.m_Value + b.m_Value;
                 }
             };
 
             template <size_t dps1, size_t dps2, typename T1, typename T2>
-            inline static constexpr
+            FIXEDPOINT_ENTRY
                 Fixed<(dps1 > dps2 ? dps1 : dps2), typename details::wider::widest<T1, T2>::type>
                 add(const Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b)
             {
@@ -199,7 +257,11 @@ namespace FixedPoint
                     f(const Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b)
                 {
                     // dps1 != dps2
-                    return subImpl<dps1, dps2, (dps1 > dps2), T1, T2 > ::f(a, b);
+                    return FIXEDPOINT_COUNT(SubRescale, dps1, dps2),
+                        FIXEDPOINT_COUNT_IF((details::instrument::sumOverflows<typename details::wider::widest<T1, T2>::type>(
+                            a.m_Value, details::Factor<(dps1 > dps2 ? 0 : dps2 - dps1)>::value,
+                            b.m_Value, details::Factor<(dps1 > dps2 ? dps1 - dps2 : 0)>::value, true)), Overflow, dps1, dps2),
+                        subImpl<dps1, dps2, (dps1 > dps2), T1, T2 > ::f(a, b);
                 }
             };
 
@@ -212,14 +274,16 @@ namespace FixedPoint
                 {
                     // dps1 == dps2
                     // do work right here
-                    return Utils::MkFxd<(dps1 > dps2 ? dps1 : dps2), 
+                    return FIXEDPOINT_COUNT_IF((details::instrument::sumOverflows<typename details::wider::widest<T1, T2>::type>(
+                            a.m_Value, 1, b.m_Value, 1, true)), Overflow, dps1, dps2),
+                        Utils::MkFxd<(dps1 > dps2 ? dps1 : dps2), 
                         typename details::wider::widest<T1, T2>::type>
                         (a.m_Value - b.m_Value);
                 }
             };
 
             template <size_t dps1, size_t dps2, typename T1, typename T2>
-            inline static constexpr
+            FIXEDPOINT_ENTRY
                 Fixed<(dps1 > dps2 ? dps1 : dps2), typename details::wider::widest<T1, T2>::type>
                 sub(const Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b)
             {
@@ -251,7 +315,8 @@ namespace FixedPoint
                 inline static constexpr bool
                     f(const Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b)
                 {	// dps1 != dps2
-                    return eqImpl<dps1, dps2, (dps1 > dps2), T1, T2>::f(a, b);
+                    return FIXEDPOINT_COUNT(EqualRescale, dps1, dps2),
+                        eqImpl<dps1, dps2, (dps1 > dps2), T1, T2>::f(a, b);
                 }
             };
 
@@ -267,7 +332,7 @@ namespace FixedPoint
             };
 
             template <size_t dps1, size_t dps2, typename T1, typename T2>
-            inline static constexpr bool equal(const Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b) {
+            FIXEDPOINT_ENTRY bool equal(const Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b) {
                 
                 return eqImplDpCompare <dps1, dps2, dps1 == dps2, T1, T2 > ::f(a, b);
             }
@@ -297,7 +362,8 @@ namespace FixedPoint
                 inline static constexpr bool
                     f(const Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b)
                 {	// dps1 != dps2
-                    return gtImpl<dps1, dps2, (dps1 > dps2), T1, T2>::f(a, b);
+                    return FIXEDPOINT_COUNT(GreaterRescale, dps1, dps2),
+                        gtImpl<dps1, dps2, (dps1 > dps2), T1, T2>::f(a, b);
                 }
             };
 
@@ -313,7 +379,7 @@ namespace FixedPoint
             };
 
             template <size_t dps1, size_t dps2, typename T1, typename T2>
-            inline static constexpr bool greater(const Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b) {
+            FIXEDPOINT_ENTRY bool greater(const Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b) {
 
                 return gtImplDpCompare <dps1, dps2, dps1 == dps2, T1, T2 > ::f(a, b);
             }
@@ -343,7 +409,8 @@ namespace FixedPoint
                 inline static constexpr bool
                     f(const Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b)
                 {	// dps1 != dps2
-                    return ltImpl<dps1, dps2, (dps1 > dps2), T1, T2>::f(a, b);
+                    return FIXEDPOINT_COUNT(LessRescale, dps1, dps2),
+                        ltImpl<dps1, dps2, (dps1 > dps2), T1, T2>::f(a, b);
                 }
             };
 
@@ -359,7 +426,7 @@ namespace FixedPoint
             };
 
             template <size_t dps1, size_t dps2, typename T1, typename T2>
-            inline static constexpr bool lesser(const Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b) {
+            FIXEDPOINT_ENTRY bool lesser(const Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b) {
 
                 return ltImplDpCompare <dps1, dps2, dps1 == dps2, T1, T2 > ::f(a, b);
             }
@@ -371,6 +438,9 @@ namespace FixedPoint
                     f(Fixed<dps1, T1>& a, const Fixed<dps2, T2> & b)
                 {	//dps1 < dps2
                     const int f = details::Factor<dps2 - dps1>::value;
+                    FIXEDPOINT_COUNT_IF(b.m_Value % f != 0, RoundingChanged, dps2, dps1);
+                    FIXEDPOINT_COUNT_IF(details::instrument::sumOverflows<T1>(a.m_Value, 1, b.m_Value / f, 1, false),
+                        Overflow, dps1, dps2);
                     if (b.m_Value > 0) 
                         a.m_Value += static_cast<T1>((b.m_Value + (f / 2)) / f);
                     else 
@@ -384,6 +454,8 @@ namespace FixedPoint
                 inline static constexpr Fixed<dps1, T1>&
                     f(Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b)
                 {	//dps1 > dps2
+                    FIXEDPOINT_COUNT_IF(details::instrument::sumOverflows<T1>(a.m_Value, 1,
+                        b.m_Value, details::Factor<dps1 - dps2>::value, false), Overflow, dps1, dps2);
                     a.m_Value += static_cast<T1>(b.m_Value *
                         (details::Factor<dps1 - dps2>::value));
                     return a;
@@ -396,7 +468,8 @@ namespace FixedPoint
                 inline static constexpr Fixed<dps1, T1>&
                     f(Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b)
                 {	// dps1 != dps2
-                    return plusEqImpl<dps1, dps2, (dps1 > dps2), T1, T2>::f(a, b);
+                    return FIXEDPOINT_COUNT(PlusEqRescale, dps1, dps2),
+                        plusEqImpl<dps1, dps2, (dps1 > dps2), T1, T2>::f(a, b);
                 }
             };
 
@@ -407,13 +480,15 @@ namespace FixedPoint
                     f(Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b)
                 {
                     // dps1 == dps2 - do work right here
+                    FIXEDPOINT_COUNT_IF(details::instrument::sumOverflows<T1>(a.m_Value, 1, b.m_Value, 1, false),
+                        Overflow, dps1, dps2);
                     a.m_Value += static_cast<T1>(b.m_Value);
                     return a;
                 }
             };
 
             template <size_t dps1, size_t dps2, typename T1, typename T2>
-            inline static constexpr Fixed<dps1, T1>& plusEqual(Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b) {
+            FIXEDPOINT_ENTRY Fixed<dps1, T1>& plusEqual(Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b) {
 
                 return plusEqImplDpCompare <dps1, dps2, dps1 == dps2, T1, T2 > ::f(a, b);
             }
@@ -425,6 +500,9 @@ namespace FixedPoint
                     f(Fixed<dps1, T1>& a, const Fixed<dps2, T2> & b)
                 {	//dps1 < dps2
                     const int f = details::Factor<dps2 - dps1>::value;
+                    FIXEDPOINT_COUNT_IF(b.m_Value % f != 0, RoundingChanged, dps2, dps1);
+                    FIXEDPOINT_COUNT_IF(details::instrument::sumOverflows<T1>(a.m_Value, 1, b.m_Value / f, 1, true),
+                        Overflow, dps1, dps2);
                     if (b.m_Value > 0)
                         a.m_Value -= static_cast<T1>((b.m_Value + (f / 2)) / f);
                     else
@@ -438,6 +516,8 @@ namespace FixedPoint
                 inline static Fixed<dps1, T1>&
                     f(Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b)
                 {	//dps1 > dps2
+                    FIXEDPOINT_COUNT_IF(details::instrument::sumOverflows<T1>(a.m_Value, 1,
+                        b.m_Value, details::Factor<dps1 - dps2>::value, true), Overflow, dps1, dps2);
                     a.m_Value -= static_cast<T1>(b.m_Value *
                         (details::Factor<dps1 - dps2>::value));
                     return a;
@@ -450,7 +530,8 @@ namespace FixedPoint
                 inline static constexpr Fixed<dps1, T1>&
                     f(Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b)
                 {	// dps1 != dps2
-                    return minusEqImpl<dps1, dps2, (dps1 > dps2), T1, T2>::f(a, b);
+                    return FIXEDPOINT_COUNT(MinusEqRescale, dps1, dps2),
+                        minusEqImpl<dps1, dps2, (dps1 > dps2), T1, T2>::f(a, b);
                 }
             };
 
@@ -461,16 +542,96 @@ namespace FixedPoint
                     f(Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b)
                 {
                     // dps1 == dps2 - do work right here
+                    FIXEDPOINT_COUNT_IF(details::instrument::sumOverflows<T1>(a.m_Value, 1, b.m_Value, 1, true),
+                        Overflow, dps1, dps2);
                     a.m_Value -= static_cast<T1>(b.m_Value);
                     return a;
                 }
             };
 
             template <size_t dps1, size_t dps2, typename T1, typename T2>
-            inline static constexpr Fixed<dps1, T1>& minusEqual(Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b) {
+            FIXEDPOINT_ENTRY Fixed<dps1, T1>& minusEqual(Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b) {
 
                 return minusEqImplDpCompare <dps1, dps2, dps1 == dps2, T1, T2 > ::f(a, b);
             }
+
+            // operator *
+            template <size_t dps1, size_t dps2, typename T1, typename T2>
+            FIXEDPOINT_ENTRY
+                Fixed<(dps1 > dps2 ? dps1 : dps2), typename details::wider::widest<T1, T2>::type>
+                mul(const Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b)
+            {
+                auto temp = a.m_Value * b.m_Value;
+                const auto f = details::Factor<(dps1 <= dps2 ? dps1 : dps2)>::value;
+                FIXEDPOINT_COUNT_IF((details::instrument::productOverflows<decltype(temp)>(a.m_Value, b.m_Value)
+                    || !details::instrument::fits<typename details::wider::widest<T1, T2>::type>(temp / f)),
+                    Overflow, dps1, dps2);
+                // the product has dps1 + dps2 places, rounded to the larger dps
+                FIXEDPOINT_COUNT_IF(temp % f != 0, RoundingChanged, dps1 + dps2, (dps1 > dps2 ? dps1 : dps2));
+                if (temp >= 0) temp += f / 2; else temp -= f / 2;
+                return Utils::MkFxd<(dps1 > dps2 ? dps1 : dps2), 
+                    typename details::wider::widest<T1, T2>::type>
+                    (temp / f);
+            }
+
+            // operator /
+            template <size_t dps1, size_t dps2, typename T1, typename T2>
+            FIXEDPOINT_ENTRY
+                Fixed<(dps1 > dps2 ? dps1 : dps2), typename details::wider::widest<T1, T2>::type>
+                div(const Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b)
+            {
+                // find max dps       
+                const auto max = details::Max<dps1, dps2>::value;
+                FIXEDPOINT_COUNT(DivideWiden, dps1, dps2);
+
+                // convert numerator to (2*max)+1
+                // Force this to use a wide value to avoid overflows
+                Fixed<2 * max + 1, long long int> num = a;
+
+                // convert denum to max
+                Fixed<max, typename details::wider::widest<T1, T2>::type> denum = b;
+
+                // divide
+                num.m_Value /= denum.m_Value;
+
+                // + 5
+                FIXEDPOINT_COUNT_IF(num.m_Value % 10 != 0, RoundingChanged, 2 * max + 1, max);
+                if (num.m_Value >= 0) num.m_Value += 5; else num.m_Value -= 5;
+
+                // / 10
+                denum.m_Value = num.m_Value / 10;
+
+                return denum; // return denum so the return type is correct and doesn't force a conversion
+            }
+
+            // operator *=
+            template <size_t dps1, size_t dps2, typename T1, typename T2>
+            FIXEDPOINT_ENTRY Fixed<dps1, T1>& mulEqual(Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b) {
+
+                typename details::wider::widest<T1, T2>::type temp = a.m_Value;
+                FIXEDPOINT_COUNT_IF(details::instrument::productOverflows<decltype(temp)>(temp, b.m_Value)
+                    || !details::instrument::fits<T1>(temp * b.m_Value / details::Factor<dps2>::value),
+                    Overflow, dps1, dps2);
+                temp *= b.m_Value;
+                FIXEDPOINT_COUNT_IF(temp % details::Factor<dps2>::value != 0, RoundingChanged, dps1 + dps2, dps1);
+                temp /= details::Factor<dps2>::value;			
+                a.m_Value =  static_cast<T1>(temp);
+                return a;
+            }
+
+            // operator /=
+            template <size_t dps1, size_t dps2, typename T1, typename T2>
+            FIXEDPOINT_ENTRY Fixed<dps1, T1>& divEqual(Fixed<dps1, T1>& a, const Fixed<dps2, T2>& b) {
+
+                typename details::wider::widest<T1, T2>::type temp = a.m_Value;
+                temp *= details::Factor<dps2 + 1>::value;
+                temp /= b.m_Value;
+                FIXEDPOINT_COUNT_IF(temp % 10 != 0, RoundingChanged, dps1 + 1, dps1);
+                if (temp >= 0) temp += 5; else temp -= 5;
+                temp /= 10;
+                a.m_Value = temp;
+                return a;
+            }
         }
 
     }
@@ -485,7 +646,7 @@ namespace FixedPoint
 
         explicit Fixed(float f)
         {
-            f *= details::Factor<dps>::value;
+            f *= static_cast<float>(details::Factor<dps>::value);
             if (f < 0) f -= 0.5f;
             else f += 0.5f;
             m_Value = f;
@@ -493,7 +654,7 @@ namespace FixedPoint
 
         explicit Fixed(double f)
         {
-            f *= details::Factor<dps>::value;
+            f *= static_cast<double>(details::Factor<dps>::value);
             if (f < 0) f -= 0.5;
             else f += 0.5;
             m_Value = static_cast<MyType>(f);
@@ -539,38 +700,14 @@ namespace FixedPoint
         Fixed<(dps > dps2 ? dps : dps2), typename details::wider::widest<MyType, T2>::type>
             operator *(const Fixed<dps2, T2>& d)
         {
-            auto temp = m_Value * d.m_Value;
-            const auto f = details::Factor<(dps <= dps2 ? dps : dps2)>::value;
-            if (temp >= 0) temp += f / 2; else temp -= f / 2;
-            return Utils::MkFxd<(dps > dps2 ? dps : dps2), 
-                typename details::wider::widest<MyType, T2>::type>
-                (temp / f);
+            return details::ops::mul(*this, d);
         }
 
         template<size_t dps2, typename T2>
         Fixed<(dps > dps2 ? dps : dps2), typename details::wider::widest<MyType, T2>::type>
             operator /(const Fixed<dps2, T2> d) const
         {
-            // find max dps       
-            const auto max = details::Max<dps, dps2>::value;
-
-            // convert numerator to (2*max)+1
-            // Force this to use a wide value to avoid overflows
-            Fixed<2 * max + 1, long long int> num = *this;
-
-            // convert denum to max
-            Fixed<max, details::wider::widest<MyType, T2>::type> denum = d;
-
-            // divide
-            num.m_Value /= denum.m_Value;
-
-            // + 5
-            if (num.m_Value >= 0) num.m_Value += 5; else num.m_Value -= 5;
-
-            // / 10
-            denum.m_Value = num.m_Value / 10;
-
-            return denum; // return denum so the return type is correct and doesn't force a conversion
+            return details::ops::div(*this, d);
         }
 
         template <size_t dps2, typename T2>
@@ -618,23 +755,13 @@ namespace FixedPoint
         template <size_t dps2, typename T2>
         inline Fixed<dps, MyType>& operator *=(const Fixed<dps2, T2>& d)
         {
-            details::wider::widest<MyType, T2>::type temp = m_Value;
-            temp *= d.m_Value;
-            temp /= details::Factor<dps2>::value;			
-            m_Value =  static_cast<MyType>(temp);
-            return *this;
+            return details::ops::mulEqual(*this, d);
         }
 
         template <size_t dps2, typename T2>
         inline Fixed<dps, MyType>& operator /=(const Fixed<dps2, T2>& d)
         {
-            details::wider::widest<MyType, T2>::type temp = m_Value;
-            temp *= details::Factor<dps2 + 1>::value;
-            temp /= d.m_Value;
-            if (temp >= 0) temp += 5; else temp -= 5;
-            temp /= 10;
-            m_Value = temp;
-            return *this;
+            return details::ops::divEqual(*this, d);
         }
 
 
@@ -652,6 +779,7 @@ namespace FixedPoint
         template<typename T> Fixed<dps, MyType> operator /(T v) const
         {
             auto temp = ((m_Value * 10) / v);
+            FIXEDPOINT_COUNT_IF(temp % 10 != 0, RoundingChanged, dps + 1, dps);
             if (temp >= 0) temp += 5; else temp -= 5;
             return Utils::MkFxd<dps, MyType>(temp / 10);
         }
@@ -681,6 +809,7 @@ namespace FixedPoint
         template<typename T> Fixed<dps, MyType>& operator /=(T v)
         {
             auto temp = ((m_Value * 10) / v);
+            FIXEDPOINT_COUNT_IF(temp % 10 != 0, RoundingChanged, dps + 1, dps);
             if (temp >= 0) temp += 5; else temp -= 5;
             m_Value = temp / 10;
             return *this;
@@ -691,6 +820,7 @@ namespace FixedPoint
         {
             const auto factor = 
                 details::Factor<static_cast<int>(dps) - decimalPlaces>::value;
+            FIXEDPOINT_COUNT_IF(m_Value % factor != 0, RoundingChanged, dps, decimalPlaces);
             if (m_Value < 0) m_Value -= (factor / 2);
             else m_Value += (factor / 2);
             m_Value /= factor;
@@ -741,7 +871,7 @@ namespace FixedPoint
 
 
         template <size_t dpsF, typename TF>
-        friend Fixed<dpsF, TF> Utils::MkFxd(TF t);
+        friend constexpr Fixed<dpsF, TF> Utils::MkFxd(TF t);
 
     };
 
@@ -767,6 +897,7 @@ namespace FixedPoint
         // NOTE: This large factor is quite dangerous
         T temp = ((T)a) * details::Factor<2*dps+1>::value;
         temp /= b.m_Value;
+        FIXEDPOINT_COUNT_IF(temp % 10 != 0, RoundingChanged, dps + 1, dps);
         if (temp >= 0) temp += 5; else temp -= 5;
         temp /= 10;		
         return Utils::MkFxd<dps, T>(temp);
@@ -841,6 +972,8 @@ namespace FixedPoint
         MyType m_Value;
         size_t m_dps;
 
+        RTFixed() : m_Value(0), m_dps(0) { }
+
         template<size_t N>
         RTFixed(const Fixed<N, MyType>& f)
             : m_Value(f.m_Value)
@@ -906,7 +1039,18 @@ namespace FixedPoint
         template <size_t dps, typename T>
         inline constexpr Fixed<dps, T> MkFxd(T t)
         {
-            return Fixed<dps,T>(t, Fixed<dps,T>::InternalValue());
+            return Fixed<dps,T>(t, typename Fixed<dps,T>::InternalValue());
+        }
+
+        // Make a runtime fixed point number from an internal value
+        // and its number of decimal places
+        template <typename T>
+        inline RTFixed<T> MkRTFxd(T t, size_t dps)
+        {
+            RTFixed<T> r;
+            r.m_Value = t;
+            r.m_dps = dps;
+            return r;
         }
     }
 
@@ -923,6 +1067,60 @@ namespace FixedPoint
         constexpr auto operator "" _fxd9(long double lld) { return ::FixedPoint::Utils::MkFxd<9>((int)(lld * 1000000000)); }
     }
 
+    // Instantiates a FixedTypes type and the operator entry points for it and
+    // every FixedTypes right hand side. X is "template" in fixed.cpp and
+    // "extern template" in FIXEDPOINT_EXTERN_TEMPLATES builds.
+#define FIXEDPOINT_INSTANTIATE_PAIR(X, dps1, T1, dps2, T2) \
+    X T1 details::ctors::scaleFixed<dps1, dps2, T1, T2>(const T2); \
+    X Fixed<(dps1 > dps2 ? dps1 : dps2), details::wider::widest<T1, T2>::type> \
+        details::ops::add(const Fixed<dps1, T1>&, const Fixed<dps2, T2>&); \
+    X Fixed<(dps1 > dps2 ? dps1 : dps2), details::wider::widest<T1, T2>::type> \
+        details::ops::sub(const Fixed<dps1, T1>&, const Fixed<dps2, T2>&); \
+    X Fixed<(dps1 > dps2 ? dps1 : dps2), details::wider::widest<T1, T2>::type> \
+        details::ops::mul(const Fixed<dps1, T1>&, const Fixed<dps2, T2>&); \
+    X Fixed<(dps1 > dps2 ? dps1 : dps2), details::wider::widest<T1, T2>::type> \
+        details::ops::div(const Fixed<dps1, T1>&, const Fixed<dps2, T2>&); \
+    X bool details::ops::equal(const Fixed<dps1, T1>&, const Fixed<dps2, T2>&); \
+    X bool details::ops::greater(const Fixed<dps1, T1>&, const Fixed<dps2, T2>&); \
+    X bool details::ops::lesser(const Fixed<dps1, T1>&, const Fixed<dps2, T2>&); \
+    X Fixed<dps1, T1>& details::ops::plusEqual(Fixed<dps1, T1>&, const Fixed<dps2, T2>&); \
+    X Fixed<dps1, T1>& details::ops::minusEqual(Fixed<dps1, T1>&, const Fixed<dps2, T2>&); \
+    X Fixed<dps1, T1>& details::ops::mulEqual(Fixed<dps1, T1>&, const Fixed<dps2, T2>&); \
+    X Fixed<dps1, T1>& details::ops::divEqual(Fixed<dps1, T1>&, const Fixed<dps2, T2>&);
+
+#define FIXEDPOINT_INSTANTIATE_TYPE(X, dps1, T1) \
+    X struct Fixed<dps1, T1>; \
+    FIXEDPOINT_INSTANTIATE_PAIR(X, dps1, T1, 1, int) \
+    FIXEDPOINT_INSTANTIATE_PAIR(X, dps1, T1, 2, int) \
+    FIXEDPOINT_INSTANTIATE_PAIR(X, dps1, T1, 3, int) \
+    FIXEDPOINT_INSTANTIATE_PAIR(X, dps1, T1, 4, int) \
+    FIXEDPOINT_INSTANTIATE_PAIR(X, dps1, T1, 5, int) \
+    FIXEDPOINT_INSTANTIATE_PAIR(X, dps1, T1, 6, int) \
+    FIXEDPOINT_INSTANTIATE_PAIR(X, dps1, T1, 1, long long int) \
+    FIXEDPOINT_INSTANTIATE_PAIR(X, dps1, T1, 2, long long int) \
+    FIXEDPOINT_INSTANTIATE_PAIR(X, dps1, T1, 3, long long int) \
+    FIXEDPOINT_INSTANTIATE_PAIR(X, dps1, T1, 4, long long int) \
+    FIXEDPOINT_INSTANTIATE_PAIR(X, dps1, T1, 5, long long int) \
+    FIXEDPOINT_INSTANTIATE_PAIR(X, dps1, T1, 6, long long int)
+
+#define FIXEDPOINT_INSTANTIATE_FIXEDTYPES(X) \
+    FIXEDPOINT_INSTANTIATE_TYPE(X, 1, int) \
+    FIXEDPOINT_INSTANTIATE_TYPE(X, 2, int) \
+    FIXEDPOINT_INSTANTIATE_TYPE(X, 3, int) \
+    FIXEDPOINT_INSTANTIATE_TYPE(X, 4, int) \
+    FIXEDPOINT_INSTANTIATE_TYPE(X, 5, int) \
+    FIXEDPOINT_INSTANTIATE_TYPE(X, 6, int) \
+    FIXEDPOINT_INSTANTIATE_TYPE(X, 1, long long int) \
+    FIXEDPOINT_INSTANTIATE_TYPE(X, 2, long long int) \
+    FIXEDPOINT_INSTANTIATE_TYPE(X, 3, long long int) \
+    FIXEDPOINT_INSTANTIATE_TYPE(X, 4, long long int) \
+    FIXEDPOINT_INSTANTIATE_TYPE(X, 5, long long int) \
+    FIXEDPOINT_INSTANTIATE_TYPE(X, 6, long long int)
+
+#if defined(FIXEDPOINT_EXTERN_TEMPLATES)
+    FIXEDPOINT_INSTANTIATE_FIXEDTYPES(extern template)
+#endif
+
 
 }
 
@@ -0,0 +1,58 @@
+#ifndef __FIXED_ARITH__73160428
+#define __FIXED_ARITH__73160428
+
+#include <cstddef> // for size_t
+#include <limits>
+
+#include "fixed.h"
+
+// Integer helpers shared by the bulk headers: powers of ten, division
+// rounding half away from zero (as the Fixed operators do) and exact sums
+namespace FixedPoint
+{
+    namespace details
+    {
+        namespace arith
+        {
+            // 10^k, which must fit in T
+            template <typename T>
+            inline T pow10(size_t k)
+            {
+                T f = 1;
+                while (k--) f *= 10;
+                return f;
+            }
+
+            // num / den rounded half away from zero, den > 0
+            template <typename T>
+            inline T divRound(T num, T den)
+            {
+                const T q = num / den;
+                const T r = num % den < 0 ? -(num % den) : num % den;
+                return (r >= den - r) ? (num < 0 ? q - 1 : q + 1) : q;
+            }
+
+            // v / 10^k rounded half away from zero, for any k
+            template <typename T>
+            inline T down(T v, size_t k)
+            {
+                const size_t digits = std::numeric_limits<T>::digits10; // 10^digits fits in T
+                if (k <= digits) return k ? divRound(v, pow10<T>(k)) : v;
+                if (k > digits + 1) return 0;
+                // 10^k does not fit, but rounding v / 10^(k - 1) by ten gives the same result
+                return divRound(static_cast<T>(v / pow10<T>(digits)), static_cast<T>(10));
+            }
+
+            // Sum of a block, exact
+            template <typename T>
+            inline typename wider::accumulate<T>::type sum(const T* in, size_t n)
+            {
+                typename wider::accumulate<T>::type s = 0;
+                for (size_t i = 0; i < n; ++i) s += in[i];
+                return s;
+            }
+        }
+    }
+}
+
+#endif
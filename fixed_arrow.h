@@ -0,0 +1,363 @@
+#ifndef __FIXED_ARROW__28461937
+#define __FIXED_ARROW__28461937
+
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+
+#include "fixed.h"
+#include "fixed_arith.h"
+#include "fixed_scan.h"
+
+// Arrow Decimal128 columns without the Arrow library.
+//
+// A Decimal128 value is a 16 byte little endian two's complement integer
+// with a scale, the same scaled integer as Fixed::m_Value with scale = dps.
+// Fixed<dps, __int128> columns are exported and imported without copying.
+// Other storage types are widened into, or narrowed and rescaled out of, a
+// caller provided buffer.
+//
+// Validity bitmaps are Arrow's: bit i set means row i is not null, least
+// significant bit first. Bitmaps written by fixed_scan.h use the same layout
+// on little endian hosts and can be passed in directly.
+//
+// The Arrow C data interface structs are declared below unless another
+// header already did, guarded by ARROW_C_DATA_INTERFACE as the spec asks.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS 4
+
+struct ArrowSchema
+{
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+    void (*release)(struct ArrowSchema*);
+    void* private_data;
+};
+
+struct ArrowArray
+{
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+    void (*release)(struct ArrowArray*);
+    void* private_data;
+};
+
+#endif
+
+namespace FixedPoint
+{
+    namespace Arrow
+    {
+        enum { Decimal128Bytes = 16, MaxPrecision = 38 };
+
+        // A Decimal128 array as laid out by Arrow. Does not own its buffers.
+        struct Decimal128Array
+        {
+            const uint8_t* m_Values;   // Decimal128Bytes per row, from row 0
+            const uint8_t* m_Validity; // 0 when no row is null
+            size_t m_Length;           // rows, starting at m_Offset
+            size_t m_Offset;           // first row, as in a sliced Arrow array
+            int m_Precision;
+            int m_Scale;
+        };
+
+        inline bool isValid(const Decimal128Array& a, size_t i)
+        {
+            const size_t r = a.m_Offset + i;
+            return !a.m_Validity || ((a.m_Validity[r >> 3] >> (r & 7)) & 1);
+        }
+    }
+
+    namespace details
+    {
+        namespace arrow
+        {
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_M_X64) || defined(_M_IX86)
+            enum { nativeLittleEndian = 1 };
+#else
+            enum { nativeLittleEndian = 0 };
+#endif
+
+#if defined(__SIZEOF_INT128__)
+            typedef __int128 Wide;
+            typedef unsigned __int128 UWide;
+#else
+            typedef long long int Wide;
+            typedef unsigned long long int UWide;
+#endif
+
+            inline uint64_t loadWord(const uint8_t* p)
+            {
+                uint64_t v = 0;
+                for (unsigned i = 0; i < 8; ++i) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+                return v;
+            }
+
+            inline void storeWord(uint8_t* p, uint64_t v)
+            {
+                for (unsigned i = 0; i < 8; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+            }
+
+            template <typename T>
+            inline void store(uint8_t* p, T v)
+            {
+                const long long int w = v;
+                storeWord(p, static_cast<uint64_t>(w));
+                storeWord(p + 8, w < 0 ? ~uint64_t(0) : uint64_t(0));
+            }
+
+#if defined(__SIZEOF_INT128__)
+            inline void store(uint8_t* p, __int128 v)
+            {
+                storeWord(p, static_cast<uint64_t>(v));
+                storeWord(p + 8, static_cast<uint64_t>(v >> 64));
+            }
+#endif
+
+            // Reads one value, false if it does not fit Wide
+            inline bool load(const uint8_t* p, Wide& v)
+            {
+                const uint64_t lo = loadWord(p);
+                const uint64_t hi = loadWord(p + 8);
+#if defined(__SIZEOF_INT128__)
+                v = static_cast<Wide>((static_cast<UWide>(hi) << 64) | lo);
+                return true;
+#else
+                v = static_cast<Wide>(lo);
+                return hi == (v < 0 ? ~uint64_t(0) : uint64_t(0));
+#endif
+            }
+
+            inline Wide maxWide()
+            {
+                return static_cast<Wide>(~static_cast<UWide>(0) >> 1);
+            }
+
+            // Largest power of ten Wide holds
+            inline int maxDigits()
+            {
+                return sizeof(Wide) > 8 ? 38 : 18;
+            }
+
+            // Moves v from scale from to scale to, rounding half away from zero.
+            // False if the result does not fit Wide.
+            inline bool rescale(Wide& v, int from, int to)
+            {
+                if (to > from)
+                {
+                    if (v == 0) return true;
+                    if (to - from > maxDigits()) return false;
+                    const Wide f = arith::pow10<Wide>(static_cast<size_t>(to - from));
+                    if (v > maxWide() / f || v < -(maxWide() / f)) return false;
+                    v *= f;
+                }
+                else if (from > to)
+                    v = arith::down(v, static_cast<size_t>(from - to));
+                return true;
+            }
+
+            template <typename T>
+            inline bool fits(Wide v)
+            {
+                if (sizeof(T) >= sizeof(Wide)) return true;
+                return v >= static_cast<Wide>(std::numeric_limits<T>::min())
+                    && v <= static_cast<Wide>(std::numeric_limits<T>::max());
+            }
+
+            // Owns the format string or buffer list handed out by exportArray
+            struct Exported
+            {
+                char m_Format[32];
+                const void* m_Buffers[2];
+            };
+
+            inline void releaseSchema(ArrowSchema* s)
+            {
+                delete static_cast<Exported*>(s->private_data);
+                s->release = 0;
+            }
+
+            inline void releaseArray(ArrowArray* a)
+            {
+                delete static_cast<Exported*>(a->private_data);
+                a->release = 0;
+            }
+        }
+    }
+
+    namespace Arrow
+    {
+#if defined(__SIZEOF_INT128__)
+        // Exposes the column as Decimal128 with scale dps, no copy.
+        // col and validity must outlive the returned array.
+        template <size_t dps>
+        inline Decimal128Array view(const Fixed<dps, __int128>* col, size_t n, const uint64_t* validity = 0)
+        {
+            static_assert(details::arrow::nativeLittleEndian, "Decimal128 views need a little endian host, use widen");
+            static_assert(sizeof(Fixed<dps, __int128>) == Decimal128Bytes, "Fixed<dps, __int128> is not 16 bytes");
+            Decimal128Array a;
+            a.m_Values = reinterpret_cast<const uint8_t*>(col);
+            a.m_Validity = reinterpret_cast<const uint8_t*>(validity);
+            a.m_Length = n;
+            a.m_Offset = 0;
+            a.m_Precision = MaxPrecision;
+            a.m_Scale = static_cast<int>(dps);
+            return a;
+        }
+
+        // The array's values as Fixed, no copy.
+        // 0 if the scale is not dps or the buffer is not aligned for __int128,
+        // use narrow then. Null rows hold whatever the producer left there.
+        template <size_t dps>
+        inline const Fixed<dps, __int128>* fixedSpan(const Decimal128Array& a)
+        {
+            if (!details::arrow::nativeLittleEndian) return 0;
+            if (a.m_Scale < 0 || static_cast<size_t>(a.m_Scale) != dps) return 0;
+            const uint8_t* p = a.m_Values + a.m_Offset * Decimal128Bytes;
+            if (reinterpret_cast<uintptr_t>(p) % alignof(Fixed<dps, __int128>) != 0) return 0;
+            return reinterpret_cast<const Fixed<dps, __int128>*>(p);
+        }
+#endif
+
+        // Copies the column into out as Decimal128 with scale dps.
+        // out needs n * Decimal128Bytes bytes, out and validity must outlive
+        // the returned array. validity is used as is, in Arrow's byte order.
+        template <size_t dps, typename T>
+        inline Decimal128Array widen(const Fixed<dps, T>* col, size_t n, uint8_t* out, const uint64_t* validity = 0)
+        {
+            for (size_t i = 0; i < n; ++i)
+                details::arrow::store(out + i * Decimal128Bytes, col[i].m_Value);
+            Decimal128Array a;
+            a.m_Values = out;
+            a.m_Validity = reinterpret_cast<const uint8_t*>(validity);
+            a.m_Length = n;
+            a.m_Offset = 0;
+            a.m_Precision = MaxPrecision;
+            a.m_Scale = static_cast<int>(dps);
+            return a;
+        }
+
+        // Copies the array into out, rescaled to dps, rounding half away from
+        // zero. Null rows become zero. Returns a.m_Length, or the first row
+        // whose value does not fit Fixed<dps, T>; rows after it are not written.
+        template <size_t dps, typename T>
+        inline size_t narrow(const Decimal128Array& a, Fixed<dps, T>* out)
+        {
+            using namespace details::arrow;
+            const uint8_t* p = a.m_Values + a.m_Offset * Decimal128Bytes;
+            for (size_t i = 0; i < a.m_Length; ++i)
+            {
+                Wide v = 0;
+                if (isValid(a, i))
+                {
+                    if (!load(p + i * Decimal128Bytes, v)) return i;
+                    if (!rescale(v, a.m_Scale, static_cast<int>(dps))) return i;
+                    if (!fits<T>(v)) return i;
+                }
+                out[i] = Utils::MkFxd<dps, T>(static_cast<T>(v));
+            }
+            return a.m_Length;
+        }
+
+        // Copies the validity of a into Bulk::bitmapWords(a.m_Length) words,
+        // the layout fixed_scan.h uses. Returns the number of null rows.
+        inline size_t validity(const Decimal128Array& a, uint64_t* bits)
+        {
+            const size_t words = Bulk::bitmapWords(a.m_Length);
+            size_t valid = 0;
+            for (size_t w = 0; w < words; ++w)
+            {
+                const size_t rows = (a.m_Length - w * 64 < 64) ? a.m_Length - w * 64 : 64;
+                uint64_t word = 0;
+                if (!a.m_Validity)
+                    word = (rows == 64) ? ~uint64_t(0) : ((uint64_t(1) << rows) - 1);
+                else
+                    for (size_t b = 0; b < rows; ++b)
+                        word |= static_cast<uint64_t>(isValid(a, w * 64 + b)) << b;
+                bits[w] = word;
+                valid += details::bits::popcount64(word);
+            }
+            return a.m_Length - valid;
+        }
+
+        // Fills out and schema for an Arrow consumer, e.g. pyarrow's
+        // Array._import_from_c. The buffers are not copied and must outlive
+        // the consumer; its release callbacks only free what this allocated.
+        inline void exportArray(const Decimal128Array& a, ArrowArray* out, ArrowSchema* schema)
+        {
+            using namespace details::arrow;
+            Exported* s = new Exported;
+            std::snprintf(s->m_Format, sizeof s->m_Format, "d:%d,%d", a.m_Precision, a.m_Scale);
+            schema->format = s->m_Format;
+            schema->name = "";
+            schema->metadata = 0;
+            schema->flags = ARROW_FLAG_NULLABLE;
+            schema->n_children = 0;
+            schema->children = 0;
+            schema->dictionary = 0;
+            schema->release = &releaseSchema;
+            schema->private_data = s;
+
+            Exported* b = new Exported;
+            b->m_Buffers[0] = a.m_Validity;
+            b->m_Buffers[1] = a.m_Values;
+            size_t nulls = 0;
+            if (a.m_Validity)
+                for (size_t i = 0; i < a.m_Length; ++i) nulls += !isValid(a, i);
+            out->length = static_cast<int64_t>(a.m_Length);
+            out->null_count = static_cast<int64_t>(nulls);
+            out->offset = static_cast<int64_t>(a.m_Offset);
+            out->n_buffers = 2;
+            out->n_children = 0;
+            out->buffers = b->m_Buffers;
+            out->children = 0;
+            out->dictionary = 0;
+            out->release = &releaseArray;
+            out->private_data = b;
+        }
+
+        // Reads an Arrow decimal128 array, "d:precision,scale[,128]".
+        // False for any other type. Nothing is copied or released, arr must
+        // stay alive while out is used.
+        inline bool importArray(const ArrowArray* arr, const ArrowSchema* schema, Decimal128Array& out)
+        {
+            const char* f = schema->format;
+            if (!f || f[0] != 'd' || f[1] != ':') return false;
+            char* end = 0;
+            const long precision = std::strtol(f + 2, &end, 10);
+            if (*end != ',') return false;
+            const long scale = std::strtol(end + 1, &end, 10);
+            if (*end == ',')
+            {
+                if (std::strtol(end + 1, &end, 10) != 128) return false;
+            }
+            if (*end != '\0' || arr->n_buffers != 2 || arr->length < 0 || arr->offset < 0) return false;
+            out.m_Validity = arr->null_count == 0 ? 0 : static_cast<const uint8_t*>(arr->buffers[0]);
+            out.m_Values = static_cast<const uint8_t*>(arr->buffers[1]);
+            out.m_Length = static_cast<size_t>(arr->length);
+            out.m_Offset = static_cast<size_t>(arr->offset);
+            out.m_Precision = static_cast<int>(precision);
+            out.m_Scale = static_cast<int>(scale);
+            return true;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,255 @@
+#ifndef __FIXED_CODEC__92614078
+#define __FIXED_CODEC__92614078
+
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "fixed.h"
+
+// Compact binary encoding of Fixed and RTFixed values into caller provided
+// buffers. Decoding an encoded value always gives back the same value.
+// T must be at most 64 bits; wider types such as __int128 do not compile.
+//
+// Single values: m_Value zigzag encoded as a LEB128 varint, small magnitudes
+// of either sign take one byte. A Fixed's dps is not written, both ends
+// agree on the type. An RTFixed's dps (0 - 15) is packed into the low four
+// bits of the first byte.
+//
+// Batches: group varint. Values go in groups of four, each group is a tag
+// holding the byte length of each zigzagged value followed by the values'
+// little endian bytes. The lengths are known before the payload is read,
+// so decoding has no per-byte branches.
+//
+// All functions return the number of bytes written or consumed, 0 when the
+// buffer is too small or the input is malformed.
+namespace FixedPoint
+{
+    namespace details
+    {
+        namespace codec
+        {
+            template <typename T>
+            struct Zigzag
+            {
+                static_assert(sizeof(T) <= 8, "the codec carries values in 64 bits, T must be at most 8 bytes");
+                typedef typename std::make_unsigned<T>::type U;
+
+                static inline U encode(T v)
+                {
+                    return static_cast<U>(static_cast<U>(v) << 1) ^ static_cast<U>(v < 0 ? ~U(0) : U(0));
+                }
+
+                static inline T decode(U z)
+                {
+                    return static_cast<T>(static_cast<U>(z >> 1) ^ static_cast<U>(0 - static_cast<U>(z & 1)));
+                }
+            };
+
+            inline size_t putVarint(uint64_t z, uint8_t* buf, size_t cap)
+            {
+                size_t i = 0;
+                while (z >= 0x80)
+                {
+                    if (i == cap) return 0;
+                    buf[i++] = static_cast<uint8_t>(z | 0x80);
+                    z >>= 7;
+                }
+                if (i == cap) return 0;
+                buf[i++] = static_cast<uint8_t>(z);
+                return i;
+            }
+
+            // At most maxBits significant bits are accepted
+            inline size_t getVarint(const uint8_t* buf, size_t len, uint64_t& z, unsigned maxBits)
+            {
+                z = 0;
+                for (size_t i = 0; i < len && i < 10; ++i)
+                {
+                    const uint64_t b = buf[i] & 0x7F;
+                    const unsigned shift = static_cast<unsigned>(7 * i);
+                    if (b && (shift >= maxBits || (maxBits - shift < 7 && (b >> (maxBits - shift)))))
+                        return 0;
+                    z |= b << shift;
+                    if (!(buf[i] & 0x80)) return i + 1;
+                }
+                return 0;
+            }
+
+            inline unsigned byteLength(uint64_t z)
+            {
+                unsigned n = 1;
+                while (n < 8 && (z >> (8 * n))) ++n;
+                return n;
+            }
+
+            inline uint64_t load(const uint8_t* p, unsigned n, size_t avail)
+            {
+                uint64_t v = 0;
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_M_X64) || defined(_M_IX86)
+                if (avail >= 8)
+                {
+                    std::memcpy(&v, p, 8);
+                    return n == 8 ? v : v & ((uint64_t(1) << (8 * n)) - 1);
+                }
+#endif
+                (void)avail;
+                for (unsigned i = 0; i < n; ++i) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+                return v;
+            }
+
+            inline void store(uint8_t* p, uint64_t v, unsigned n)
+            {
+                for (unsigned i = 0; i < n; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+            }
+
+            // Group layout: lenBits per value length, four values per group
+            template <typename T>
+            struct Group
+            {
+                enum
+                {
+                    lenBits = sizeof(T) <= 4 ? 2 : 3,
+                    tagBytes = (4 * lenBits + 7) / 8
+                };
+            };
+        }
+    }
+
+    namespace Wire
+    {
+        // Largest encoding of a single Fixed<dps, T>
+        template <typename T>
+        inline size_t maxSize()
+        {
+            return (sizeof(T) * 8 + 6) / 7;
+        }
+
+        // Largest encoding of a single RTFixed<T>
+        template <typename T>
+        inline size_t maxRTSize()
+        {
+            return 1 + (sizeof(T) * 8 - 3 + 6) / 7;
+        }
+
+        // Largest encoding of a batch of n values
+        template <typename T>
+        inline size_t maxBatchSize(size_t n)
+        {
+            return (n + 3) / 4 * details::codec::Group<T>::tagBytes + n * sizeof(T);
+        }
+
+        template <size_t dps, typename T>
+        inline size_t encode(const Fixed<dps, T>& v, uint8_t* buf, size_t cap)
+        {
+            static_assert(sizeof(T) <= 8, "the codec carries values in 64 bits, T must be at most 8 bytes");
+            return details::codec::putVarint(details::codec::Zigzag<T>::encode(v.m_Value), buf, cap);
+        }
+
+        template <size_t dps, typename T>
+        inline size_t decode(const uint8_t* buf, size_t len, Fixed<dps, T>& v)
+        {
+            static_assert(sizeof(T) <= 8, "the codec carries values in 64 bits, T must be at most 8 bytes");
+            uint64_t z;
+            const size_t used = details::codec::getVarint(buf, len, z, sizeof(T) * 8);
+            if (used)
+                v = Utils::MkFxd<dps>(details::codec::Zigzag<T>::decode(
+                    static_cast<typename std::make_unsigned<T>::type>(z)));
+            return used;
+        }
+
+        // first byte: continuation bit, 3 low bits of the zigzagged value, dps
+        template <typename T>
+        inline size_t encode(const RTFixed<T>& v, uint8_t* buf, size_t cap)
+        {
+            static_assert(sizeof(T) <= 8, "the codec carries values in 64 bits, T must be at most 8 bytes");
+            if (!cap || v.m_dps > 15) return 0;
+            const uint64_t z = details::codec::Zigzag<T>::encode(v.m_Value);
+            const uint64_t rest = z >> 3;
+            buf[0] = static_cast<uint8_t>((rest ? 0x80 : 0) | ((z & 7) << 4) | v.m_dps);
+            if (!rest) return 1;
+            const size_t used = details::codec::putVarint(rest, buf + 1, cap - 1);
+            return used ? used + 1 : 0;
+        }
+
+        template <typename T>
+        inline size_t decode(const uint8_t* buf, size_t len, RTFixed<T>& v)
+        {
+            static_assert(sizeof(T) <= 8, "the codec carries values in 64 bits, T must be at most 8 bytes");
+            if (!len) return 0;
+            uint64_t rest = 0;
+            size_t used = 1;
+            if (buf[0] & 0x80)
+            {
+                const size_t more = details::codec::getVarint(buf + 1, len - 1, rest, sizeof(T) * 8 - 3);
+                if (!more) return 0;
+                used += more;
+            }
+            const uint64_t z = (rest << 3) | ((buf[0] >> 4) & 7);
+            v = Utils::MkRTFxd(details::codec::Zigzag<T>::decode(
+                static_cast<typename std::make_unsigned<T>::type>(z)), static_cast<size_t>(buf[0] & 0x0F));
+            return used;
+        }
+
+        template <size_t dps, typename T>
+        size_t encodeBatch(const Fixed<dps, T>* in, size_t n, uint8_t* buf, size_t cap)
+        {
+            static_assert(sizeof(T) <= 8, "the codec carries values in 64 bits, T must be at most 8 bytes");
+            typedef details::codec::Group<T> G;
+            size_t pos = 0;
+            for (size_t g = 0; g < n; g += 4)
+            {
+                const size_t m = (n - g < 4) ? n - g : 4;
+                uint64_t z[4];
+                unsigned bytes[4];
+                unsigned tag = 0;
+                size_t size = G::tagBytes;
+                for (size_t j = 0; j < m; ++j)
+                {
+                    z[j] = details::codec::Zigzag<T>::encode(in[g + j].m_Value);
+                    bytes[j] = details::codec::byteLength(z[j]);
+                    tag |= (bytes[j] - 1) << (j * G::lenBits);
+                    size += bytes[j];
+                }
+                if (cap - pos < size) return 0;
+                details::codec::store(buf + pos, tag, G::tagBytes);
+                pos += G::tagBytes;
+                for (size_t j = 0; j < m; ++j)
+                {
+                    details::codec::store(buf + pos, z[j], bytes[j]);
+                    pos += bytes[j];
+                }
+            }
+            return pos;
+        }
+
+        template <size_t dps, typename T>
+        size_t decodeBatch(const uint8_t* buf, size_t len, Fixed<dps, T>* out, size_t n)
+        {
+            static_assert(sizeof(T) <= 8, "the codec carries values in 64 bits, T must be at most 8 bytes");
+            typedef details::codec::Group<T> G;
+            typedef typename std::make_unsigned<T>::type U;
+            const unsigned mask = (1u << G::lenBits) - 1;
+            size_t pos = 0;
+            for (size_t g = 0; g < n; g += 4)
+            {
+                const size_t m = (n - g < 4) ? n - g : 4;
+                if (len - pos < static_cast<size_t>(G::tagBytes)) return 0;
+                const unsigned tag = static_cast<unsigned>(details::codec::load(buf + pos, G::tagBytes, 0));
+                pos += G::tagBytes;
+                for (size_t j = 0; j < m; ++j)
+                {
+                    const unsigned bytes = ((tag >> (j * G::lenBits)) & mask) + 1;
+                    if (bytes > sizeof(T) || len - pos < bytes) return 0;
+                    const uint64_t z = details::codec::load(buf + pos, bytes, len - pos);
+                    out[g + j] = Utils::MkFxd<dps>(details::codec::Zigzag<T>::decode(static_cast<U>(z)));
+                    pos += bytes;
+                }
+            }
+            return pos;
+        }
+    }
+}
+
+#endif
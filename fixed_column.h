@@ -0,0 +1,371 @@
+#ifndef __FIXED_COLUMN__53719046
+#define __FIXED_COLUMN__53719046
+
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "fixed.h"
+#include "fixed_arith.h"
+#include "fixed_scan.h"
+
+// A column of runtime dps values, e.g. prices of instruments quoted to 2, 4
+// or 8 decimals. Values are stored as raw integers in blocks of consecutive
+// rows sharing one dps, so a value costs sizeof(T) rather than an RTFixed's
+// sizeof(T) + sizeof(size_t).
+//
+// The kernels below loop over each block's raw values at its own dps, at
+// the speed of the Fixed kernels. Values are only rescaled where two blocks
+// of different dps meet, or when a result needs a single dps. dps must be
+// below 19 and 10^dps must fit in T, so any two blocks can be brought to a
+// common dps with one factor that fits in T.
+namespace FixedPoint
+{
+    template <typename T = config::DefaultType>
+    struct RTFixedColumn
+    {
+        // Rows [m_Begin, m_Begin + m_Count) are stored with m_Dps decimal places
+        struct Block
+        {
+            size_t m_Begin;
+            size_t m_Count;
+            size_t m_Dps;
+        };
+
+        inline size_t size() const { return m_Values.size(); }
+        inline bool empty() const { return m_Values.empty(); }
+        inline size_t blockCount() const { return m_Blocks.size(); }
+        inline const Block& block(size_t b) const { return m_Blocks[b]; }
+
+        // Raw values of block b
+        inline const T* data(size_t b) const { return m_Values.data() + m_Blocks[b].m_Begin; }
+        inline T* data(size_t b) { return m_Values.data() + m_Blocks[b].m_Begin; }
+
+        inline void reserve(size_t n) { m_Values.reserve(n); }
+
+        inline void clear()
+        {
+            m_Values.clear();
+            m_Blocks.clear();
+        }
+
+        // Largest dps a block may have: 10^dpsLimit fits in T and is below 10^19
+        enum { dpsLimit = std::numeric_limits<T>::digits10 < 18 ? std::numeric_limits<T>::digits10 : 18 };
+
+        // Appends n zero values with the given dps and returns their storage.
+        // Extends the last block when its dps matches. Throws
+        // std::invalid_argument when dps is above dpsLimit.
+        inline T* extend(size_t n, size_t dps)
+        {
+            if (dps > static_cast<size_t>(dpsLimit))
+                throw std::invalid_argument("RTFixedColumn: dps out of range for the value type");
+            const size_t begin = m_Values.size();
+            m_Values.resize(begin + n, T(0));
+            if (!m_Blocks.empty() && m_Blocks.back().m_Dps == dps)
+                m_Blocks.back().m_Count += n;
+            else if (n)
+            {
+                const Block b = { begin, n, dps };
+                m_Blocks.push_back(b);
+            }
+            return m_Values.data() + begin;
+        }
+
+        inline void push_back(const RTFixed<T>& v)
+        {
+            *extend(1, v.m_dps) = v.m_Value;
+        }
+
+        template <size_t dps>
+        inline void push_back(const Fixed<dps, T>& v)
+        {
+            *extend(1, dps) = v.m_Value;
+        }
+
+        inline void append(const T* raw, size_t n, size_t dps)
+        {
+            std::copy(raw, raw + n, extend(n, dps));
+        }
+
+        template <size_t dps>
+        inline void append(const Fixed<dps, T>* col, size_t n)
+        {
+            append(details::scan::raw(col), n, dps);
+        }
+
+        // Block holding row i
+        inline size_t find(size_t i) const
+        {
+            size_t lo = 0, hi = m_Blocks.size();
+            while (hi - lo > 1)
+            {
+                const size_t mid = lo + (hi - lo) / 2;
+                if (m_Blocks[mid].m_Begin <= i) lo = mid; else hi = mid;
+            }
+            return lo;
+        }
+
+        inline RTFixed<T> get(size_t i) const
+        {
+            return Utils::MkRTFxd(m_Values[i], m_Blocks[find(i)].m_Dps);
+        }
+
+        inline RTFixed<T> operator[](size_t i) const { return get(i); }
+
+        // Largest dps of any block, 0 when empty
+        inline size_t maxDps() const
+        {
+            size_t d = 0;
+            for (size_t b = 0; b < m_Blocks.size(); ++b) d = std::max(d, m_Blocks[b].m_Dps);
+            return d;
+        }
+
+    private:
+        std::vector<T> m_Values;
+        std::vector<Block> m_Blocks;
+    };
+
+    namespace details
+    {
+        namespace column
+        {
+            // v * 10^k, sets overflow instead when it does not fit in Acc
+            template <typename Acc>
+            inline Acc scaleUp(Acc v, size_t k, bool& overflow)
+            {
+                if (!k || !v) return v;
+                const Acc f = arith::pow10<Acc>(k);
+                const Acc max = std::numeric_limits<Acc>::max() / f;
+                if (v > max || v < -max)
+                {
+                    overflow = true;
+                    return v;
+                }
+                return v * f;
+            }
+
+            // a + b, sets overflow instead when it does not fit in Acc
+            template <typename Acc>
+            inline Acc checkedAdd(Acc a, Acc b, bool& overflow)
+            {
+                if (b > 0 ? a > std::numeric_limits<Acc>::max() - b : a < std::numeric_limits<Acc>::min() - b)
+                {
+                    overflow = true;
+                    return a;
+                }
+                return a + b;
+            }
+
+            // out = a + b at a common dps; factor scales the side with fewer dps
+            template <typename T>
+            inline void add(const T* a, const T* b, T* out, size_t n)
+            {
+                for (size_t i = 0; i < n; ++i) out[i] = a[i] + b[i];
+            }
+
+            template <typename T>
+            inline void addScaledA(const T* a, T factor, const T* b, T* out, size_t n)
+            {
+                for (size_t i = 0; i < n; ++i) out[i] = a[i] * factor + b[i];
+            }
+
+            template <typename T>
+            inline void addScaledB(const T* a, const T* b, T factor, T* out, size_t n)
+            {
+                for (size_t i = 0; i < n; ++i) out[i] = a[i] + b[i] * factor;
+            }
+
+            // Sets bits [at, at + n) of out from src, whose bit 0 is row at.
+            // Bits of out at or above at must be clear.
+            inline void splice(const uint64_t* src, size_t n, size_t at, uint64_t* out)
+            {
+                const size_t shift = at % 64;
+                uint64_t* o = out + at / 64;
+                for (size_t w = 0; w < Bulk::bitmapWords(n); ++w)
+                {
+                    o[w] |= src[w] << shift;
+                    if (shift && w * 64 + (64 - shift) < n) o[w + 1] |= src[w] >> (64 - shift);
+                }
+            }
+
+            // Scans every block with the range make(dps) builds for its dps
+            template <typename T, typename MakeRange>
+            inline size_t scanBlocks(const RTFixedColumn<T>& col, MakeRange make, uint64_t* bits)
+            {
+                std::fill(bits, bits + Bulk::bitmapWords(col.size()), uint64_t(0));
+                std::vector<uint64_t> tmp;
+                size_t count = 0;
+                for (size_t b = 0; b < col.blockCount(); ++b)
+                {
+                    const typename RTFixedColumn<T>::Block& blk = col.block(b);
+                    const Bulk::ScanRange<0, T> r = make(blk.m_Dps);
+                    if (r.none) continue;
+                    const size_t full = blk.m_Count / 64;
+                    const size_t tail = blk.m_Count % 64;
+                    tmp.resize(Bulk::bitmapWords(blk.m_Count));
+                    const T* v = col.data(b);
+                    count += scan::rangeWordsImpl<T>::f(v, full, r.lo, r.hi, tmp.data());
+                    if (tail)
+                    {
+                        tmp[full] = scan::rangeWordScalar(v + full * 64, tail, r.lo, r.hi);
+                        count += bits::popcount64(tmp[full]);
+                    }
+                    splice(tmp.data(), blk.m_Count, blk.m_Begin, bits);
+                }
+                return count;
+            }
+        }
+    }
+
+    namespace Bulk
+    {
+        // Sum of the column at its largest dps. Each block is summed at its
+        // own dps and rescaled once. overflow, if given, is set when the sum
+        // does not fit in a long long.
+        template <typename T>
+        inline RTFixed<long long int> sum(const RTFixedColumn<T>& col, bool* overflow = 0)
+        {
+            typedef typename details::wider::accumulate<T>::type Acc;
+            const size_t dps = col.maxDps();
+            bool over = false;
+            Acc total = 0;
+            for (size_t b = 0; b < col.blockCount() && !over; ++b)
+            {
+                const Acc s = details::arith::sum(col.data(b), col.block(b).m_Count);
+                total = details::column::checkedAdd(total, details::column::scaleUp(s, dps - col.block(b).m_Dps, over), over);
+            }
+            over = over || total > static_cast<Acc>(std::numeric_limits<long long>::max())
+                || total < static_cast<Acc>(std::numeric_limits<long long>::min());
+            if (overflow) *overflow = over;
+            return Utils::MkRTFxd(static_cast<long long int>(total), dps);
+        }
+
+        // out = a + b row by row, for the rows both have. out must not be a or b.
+        // Rows where both blocks share a dps are added as they are, others at
+        // the larger of the two dps. As for Fixed, overflow is not checked and
+        // is undefined behaviour for signed T; keep values within range.
+        template <typename T>
+        inline void add(const RTFixedColumn<T>& a, const RTFixedColumn<T>& b, RTFixedColumn<T>& out)
+        {
+            out.clear();
+            out.reserve(a.size());
+            size_t ba = 0, bb = 0, row = 0;
+            const size_t n = std::min(a.size(), b.size());
+            while (row < n)
+            {
+                const typename RTFixedColumn<T>::Block& x = a.block(ba);
+                const typename RTFixedColumn<T>::Block& y = b.block(bb);
+                const size_t endA = x.m_Begin + x.m_Count;
+                const size_t endB = y.m_Begin + y.m_Count;
+                const size_t end = std::min(endA, endB);
+                const T* pa = a.data(ba) + (row - x.m_Begin);
+                const T* pb = b.data(bb) + (row - y.m_Begin);
+                const size_t dps = std::max(x.m_Dps, y.m_Dps);
+                T* o = out.extend(end - row, dps);
+                if (x.m_Dps == y.m_Dps)
+                    details::column::add(pa, pb, o, end - row);
+                else if (x.m_Dps < y.m_Dps)
+                    details::column::addScaledA(pa, details::arith::pow10<T>(dps - x.m_Dps), pb, o, end - row);
+                else
+                    details::column::addScaledB(pa, pb, details::arith::pow10<T>(dps - y.m_Dps), o, end - row);
+                row = end;
+                if (row == endA) ++ba;
+                if (row == endB) ++bb;
+            }
+        }
+
+        // Rescales every value to dps, rounding half away from zero, so the
+        // column can be passed to the Fixed kernels. out needs col.size() entries.
+        template <size_t dps, typename T>
+        inline void normalize(const RTFixedColumn<T>& col, Fixed<dps, T>* out)
+        {
+            static_assert(dps <= static_cast<size_t>(RTFixedColumn<T>::dpsLimit), "10^dps must fit in T");
+            for (size_t b = 0; b < col.blockCount(); ++b)
+            {
+                const typename RTFixedColumn<T>::Block& blk = col.block(b);
+                const T* v = col.data(b);
+                Fixed<dps, T>* o = out + blk.m_Begin;
+                if (blk.m_Dps == dps)
+                    for (size_t i = 0; i < blk.m_Count; ++i) o[i] = Utils::MkFxd<dps, T>(v[i]);
+                else if (blk.m_Dps < dps)
+                {
+                    const T f = details::arith::pow10<T>(dps - blk.m_Dps);
+                    for (size_t i = 0; i < blk.m_Count; ++i) o[i] = Utils::MkFxd<dps, T>(v[i] * f);
+                }
+                else
+                    for (size_t i = 0; i < blk.m_Count; ++i)
+                        o[i] = Utils::MkFxd<dps, T>(details::arith::down(v[i], blk.m_Dps - dps));
+            }
+        }
+
+        // Predicate scans, as in fixed_scan.h. The constant is rescaled once
+        // per block to that block's dps. bits needs bitmapWords(col.size()) words.
+        template <typename T, size_t dps2, typename T2>
+        inline size_t scanGreater(const RTFixedColumn<T>& col, const Fixed<dps2, T2>& c, uint64_t* bits)
+        {
+            return details::column::scanBlocks(col, [&](size_t dps)
+            {
+                const details::scan::Bound top = { 1, 0 };
+                return ScanRange<0, T>::make(details::scan::plusOne(
+                    details::scan::threshold(c.m_Value, dps2, dps, false)), top);
+            }, bits);
+        }
+
+        template <typename T, size_t dps2, typename T2>
+        inline size_t scanGreaterEqual(const RTFixedColumn<T>& col, const Fixed<dps2, T2>& c, uint64_t* bits)
+        {
+            return details::column::scanBlocks(col, [&](size_t dps)
+            {
+                const details::scan::Bound top = { 1, 0 };
+                return ScanRange<0, T>::make(details::scan::threshold(c.m_Value, dps2, dps, true), top);
+            }, bits);
+        }
+
+        template <typename T, size_t dps2, typename T2>
+        inline size_t scanLess(const RTFixedColumn<T>& col, const Fixed<dps2, T2>& c, uint64_t* bits)
+        {
+            return details::column::scanBlocks(col, [&](size_t dps)
+            {
+                const details::scan::Bound bottom = { -1, 0 };
+                return ScanRange<0, T>::make(bottom, details::scan::minusOne(
+                    details::scan::threshold(c.m_Value, dps2, dps, true)));
+            }, bits);
+        }
+
+        template <typename T, size_t dps2, typename T2>
+        inline size_t scanLessEqual(const RTFixedColumn<T>& col, const Fixed<dps2, T2>& c, uint64_t* bits)
+        {
+            return details::column::scanBlocks(col, [&](size_t dps)
+            {
+                const details::scan::Bound bottom = { -1, 0 };
+                return ScanRange<0, T>::make(bottom, details::scan::threshold(c.m_Value, dps2, dps, false));
+            }, bits);
+        }
+
+        template <typename T, size_t dps2, typename T2>
+        inline size_t scanEqual(const RTFixedColumn<T>& col, const Fixed<dps2, T2>& c, uint64_t* bits)
+        {
+            return details::column::scanBlocks(col, [&](size_t dps)
+            {
+                return ScanRange<0, T>::make(details::scan::threshold(c.m_Value, dps2, dps, true),
+                    details::scan::threshold(c.m_Value, dps2, dps, false));
+            }, bits);
+        }
+
+        template <typename T, size_t dpsA, typename TA, size_t dpsB, typename TB>
+        inline size_t scanBetween(const RTFixedColumn<T>& col,
+            const Fixed<dpsA, TA>& a, const Fixed<dpsB, TB>& b, uint64_t* bits)
+        {
+            return details::column::scanBlocks(col, [&](size_t dps)
+            {
+                return ScanRange<0, T>::make(details::scan::threshold(a.m_Value, dpsA, dps, true),
+                    details::scan::threshold(b.m_Value, dpsB, dps, false));
+            }, bits);
+        }
+    }
+}
+
+#endif
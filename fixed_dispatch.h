@@ -0,0 +1,144 @@
+#ifndef __FIXED_DISPATCH__15938274
+#define __FIXED_DISPATCH__15938274
+
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FIXEDPOINT_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define FIXEDPOINT_X86 0
+#endif
+
+// Compiles a function for an instruction set the rest of the build may not
+// enable, e.g. FIXEDPOINT_TARGET("avx2"). MSVC needs no flag for intrinsics.
+#if defined(__GNUC__)
+#define FIXEDPOINT_TARGET(isa) __attribute__((target(isa)))
+#else
+#define FIXEDPOINT_TARGET(isa)
+#endif
+
+// Runtime selection of the SIMD kernels used by the bulk column operations.
+// The CPU is probed once, on first use. Every kernel keeps one
+// implementation per Level and calls the one for the active level, so one
+// binary runs the best code each host supports.
+//
+// The environment variable FIXEDPOINT_SIMD (scalar, sse42, avx2, avx512)
+// lowers the level, e.g. to test or benchmark every path on one machine.
+// A level the CPU does not support is never selected.
+namespace FixedPoint
+{
+    namespace Dispatch
+    {
+        enum Level
+        {
+            Scalar = 0,
+            SSE42 = 1,
+            AVX2 = 2,
+            AVX512 = 3,
+            LevelCount = 4
+        };
+
+        inline const char* name(Level l)
+        {
+            switch (l)
+            {
+            case SSE42: return "sse42";
+            case AVX2: return "avx2";
+            case AVX512: return "avx512";
+            default: return "scalar";
+            }
+        }
+
+        // Best level this CPU and OS support
+        inline Level detect()
+        {
+#if FIXEDPOINT_X86 && defined(__GNUC__)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f")) return AVX512;
+            if (__builtin_cpu_supports("avx2")) return AVX2;
+            if (__builtin_cpu_supports("sse4.2")) return SSE42;
+            return Scalar;
+#elif FIXEDPOINT_X86 && defined(_MSC_VER)
+            int r[4];
+            __cpuid(r, 0);
+            const int maxLeaf = r[0];
+            __cpuid(r, 1);
+            const bool sse42 = (r[2] & (1 << 20)) != 0;
+            const bool osxsave = (r[2] & (1 << 27)) != 0;
+            const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+            bool avx2 = false, avx512 = false;
+            if (maxLeaf >= 7 && (xcr0 & 0x6) == 0x6)
+            {
+                __cpuidex(r, 7, 0);
+                avx2 = (r[1] & (1 << 5)) != 0;
+                avx512 = (r[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6;
+            }
+            return avx512 ? AVX512 : avx2 ? AVX2 : sse42 ? SSE42 : Scalar;
+#else
+            return Scalar;
+#endif
+        }
+    }
+
+    namespace details
+    {
+        namespace dispatch
+        {
+            // Level named by FIXEDPOINT_SIMD, or LevelCount if unset or unknown
+            inline Dispatch::Level fromEnvironment()
+            {
+                const char* env = std::getenv("FIXEDPOINT_SIMD");
+                if (!env) return Dispatch::LevelCount;
+                for (int l = Dispatch::Scalar; l < Dispatch::LevelCount; ++l)
+                    if (std::strcmp(env, Dispatch::name(static_cast<Dispatch::Level>(l))) == 0)
+                        return static_cast<Dispatch::Level>(l);
+                return Dispatch::LevelCount;
+            }
+
+            inline std::atomic<int>& active()
+            {
+                static std::atomic<int> level(-1);
+                return level;
+            }
+
+            inline Dispatch::Level supported()
+            {
+                static const Dispatch::Level l = Dispatch::detect();
+                return l;
+            }
+        }
+    }
+
+    namespace Dispatch
+    {
+        // Level the kernels run at
+        inline Level level()
+        {
+            int l = details::dispatch::active().load(std::memory_order_relaxed);
+            if (l < 0)
+            {
+                const Level env = details::dispatch::fromEnvironment();
+                l = (env < details::dispatch::supported()) ? env : details::dispatch::supported();
+                details::dispatch::active().store(l, std::memory_order_relaxed);
+            }
+            return static_cast<Level>(l);
+        }
+
+        // Overrides the level, capped at what the CPU supports.
+        // Returns the level now in use.
+        inline Level setLevel(Level l)
+        {
+            if (l > details::dispatch::supported()) l = details::dispatch::supported();
+            details::dispatch::active().store(l, std::memory_order_relaxed);
+            return l;
+        }
+    }
+}
+
+#endif
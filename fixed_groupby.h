@@ -0,0 +1,196 @@
+#ifndef __FIXED_GROUPBY__83047126
+#define __FIXED_GROUPBY__83047126
+
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "fixed.h"
+#include "fixed_arith.h"
+#include "fixed_parallel.h"
+
+// Group-by aggregation of a Fixed column keyed by a parallel integer id column.
+// Each thread aggregates a contiguous chunk of rows into its own open
+// addressing table, the partial tables are merged at the end and groups are
+// returned sorted by key. Sums are exact integers, so the output is the same
+// whatever the thread count.
+namespace FixedPoint
+{
+    namespace Bulk
+    {
+        template <size_t dps, typename T = config::DefaultType, typename Key = long long int>
+        struct GroupStats
+        {
+            Key key;
+            size_t count;
+            Fixed<dps, long long int> sum;
+            Fixed<dps, T> min;
+            Fixed<dps, T> max;
+            Fixed<dps, long long int> mean; // rounded half away from zero
+            bool overflow;                  // sum does not fit in a long long
+        };
+    }
+
+    namespace details
+    {
+        namespace groupby
+        {
+            inline uint64_t hash(uint64_t k)
+            {
+                k ^= k >> 33;
+                k *= 0xff51afd7ed558ccdULL;
+                k ^= k >> 33;
+                k *= 0xc4ceb9fe1a85ec53ULL;
+                k ^= k >> 33;
+                return k;
+            }
+
+            // Linear probing table, count == 0 marks an empty slot
+            template <typename Key, typename T>
+            struct Table
+            {
+                typedef typename wider::accumulate<T>::type Acc;
+
+                struct Slot
+                {
+                    Key key;
+                    size_t count;
+                    Acc sum;
+                    T min;
+                    T max;
+                };
+
+                std::vector<Slot> m_Slots;
+                size_t m_Used;
+
+                Table() : m_Slots(64), m_Used(0)
+                {
+                    for (size_t i = 0; i < m_Slots.size(); ++i) m_Slots[i].count = 0;
+                }
+
+                inline Slot& find(Key key)
+                {
+                    const size_t mask = m_Slots.size() - 1;
+                    size_t i = static_cast<size_t>(hash(static_cast<uint64_t>(key))) & mask;
+                    while (m_Slots[i].count && m_Slots[i].key != key)
+                        i = (i + 1) & mask;
+                    return m_Slots[i];
+                }
+
+                inline Slot& insert(Key key)
+                {
+                    Slot* s = &find(key);
+                    if (s->count) return *s;
+                    if ((m_Used + 1) * 2 > m_Slots.size())
+                    {
+                        grow();
+                        s = &find(key);
+                    }
+                    ++m_Used;
+                    s->key = key;
+                    s->sum = 0;
+                    s->min = std::numeric_limits<T>::max();
+                    s->max = std::numeric_limits<T>::min();
+                    return *s;
+                }
+
+                inline void add(Key key, T v)
+                {
+                    Slot& s = insert(key);
+                    ++s.count;
+                    s.sum += v;
+                    if (v < s.min) s.min = v;
+                    if (v > s.max) s.max = v;
+                }
+
+                inline void merge(const Slot& o)
+                {
+                    Slot& s = insert(o.key);
+                    s.count += o.count;
+                    s.sum += o.sum;
+                    if (o.min < s.min) s.min = o.min;
+                    if (o.max > s.max) s.max = o.max;
+                }
+
+                void grow()
+                {
+                    std::vector<Slot> old(m_Slots.size() * 2);
+                    old.swap(m_Slots);
+                    for (size_t i = 0; i < m_Slots.size(); ++i) m_Slots[i].count = 0;
+                    for (size_t i = 0; i < old.size(); ++i)
+                        if (old[i].count) find(old[i].key) = old[i];
+                }
+            };
+
+            // sum / count rounded half away from zero
+            template <typename Acc>
+            inline Acc mean(Acc sum, size_t count)
+            {
+                return arith::divRound(sum, static_cast<Acc>(count));
+            }
+
+            template <typename Acc>
+            inline bool fitsLongLong(Acc v)
+            {
+                return v >= static_cast<Acc>(std::numeric_limits<long long int>::min())
+                    && v <= static_cast<Acc>(std::numeric_limits<long long int>::max());
+            }
+        }
+    }
+
+    namespace Bulk
+    {
+        // Aggregates values[i] into the group keys[i] for every row i.
+        // filter, if given, is a bitmap from fixed_scan.h selecting the rows to use.
+        // threads == 0 uses one thread per hardware thread.
+        template <size_t dps, typename T, typename Key>
+        std::vector<GroupStats<dps, T, Key> > groupBy(const Key* keys, const Fixed<dps, T>* values,
+            size_t n, size_t threads = 0, const uint64_t* filter = 0)
+        {
+            typedef details::groupby::Table<Key, T> Table;
+            typedef typename Table::Acc Acc;
+
+            const size_t count = details::parallel::threadCount(threads, n, 1 << 16);
+            std::vector<Table> partial(count);
+            details::parallel::run(count, [&](size_t t)
+            {
+                size_t begin, end;
+                details::parallel::chunk(n, count, t, begin, end);
+                Table& table = partial[t];
+                for (size_t i = begin; i < end; ++i)
+                    if (!filter || ((filter[i / 64] >> (i % 64)) & 1))
+                        table.add(keys[i], values[i].m_Value);
+            });
+
+            Table& all = partial[0];
+            for (size_t t = 1; t < count; ++t)
+                for (size_t i = 0; i < partial[t].m_Slots.size(); ++i)
+                    if (partial[t].m_Slots[i].count) all.merge(partial[t].m_Slots[i]);
+
+            std::vector<GroupStats<dps, T, Key> > out;
+            out.reserve(all.m_Used);
+            for (size_t i = 0; i < all.m_Slots.size(); ++i)
+            {
+                const typename Table::Slot& s = all.m_Slots[i];
+                if (!s.count) continue;
+                const Acc avg = details::groupby::mean(s.sum, s.count);
+                GroupStats<dps, T, Key> g;
+                g.key = s.key;
+                g.count = s.count;
+                g.overflow = !details::groupby::fitsLongLong(s.sum);
+                g.sum = Utils::MkFxd<dps>(static_cast<long long int>(s.sum));
+                g.min = Utils::MkFxd<dps>(s.min);
+                g.max = Utils::MkFxd<dps>(s.max);
+                g.mean = Utils::MkFxd<dps>(static_cast<long long int>(avg));
+                out.push_back(g);
+            }
+            std::sort(out.begin(), out.end(),
+                [](const GroupStats<dps, T, Key>& a, const GroupStats<dps, T, Key>& b) { return a.key < b.key; });
+            return out;
+        }
+    }
+}
+
+#endif
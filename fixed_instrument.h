@@ -0,0 +1,295 @@
+#ifndef __FIXED_INSTRUMENT__70493518
+#define __FIXED_INSTRUMENT__70493518
+
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// Hot path counters for Fixed operations.
+// Build with FIXEDPOINT_INSTRUMENT defined to count, per thread, every
+// rescale, mixed dps compare or arithmetic op, division widening,
+// rounding that changed a value and result that did not fit its type,
+// keyed by the dps pair involved. Rescales and roundings are keyed
+// (from dps, to dps). Overflow is checked for rescales and for +, -, *,
+// +=, -= and *=; / and /= go through a wider value and are not checked.
+// Without it the hooks in fixed.h compile to nothing and every snapshot is
+// empty. Instrumented Fixed conversions cannot be used in constant
+// expressions.
+namespace FixedPoint
+{
+    namespace Instrument
+    {
+        enum Op
+        {
+            RescaleUp,       // Fixed<a> -> Fixed<b>, a < b
+            RescaleDown,     // Fixed<a> -> Fixed<b>, a > b
+            RoundingChanged, // a rounding step discarded a non-zero remainder
+            EqualRescale,    // ==, != with different dps
+            GreaterRescale,  // >, <= with different dps
+            LessRescale,     // <, >= with different dps
+            AddRescale,      // + with different dps
+            SubRescale,      // - with different dps
+            PlusEqRescale,   // += with different dps
+            MinusEqRescale,  // -= with different dps
+            DivideWiden,     // Fixed / Fixed through Fixed<2 * max + 1>
+            Overflow,        // a rescale or arithmetic result did not fit its type
+            OpCount
+        };
+
+        // dps at or above this share the last slot
+        enum { MaxDps = 20 };
+
+        inline const char* name(Op op)
+        {
+            switch (op)
+            {
+            case RescaleUp: return "rescale up";
+            case RescaleDown: return "rescale down";
+            case RoundingChanged: return "rounding changed value";
+            case EqualRescale: return "== rescale";
+            case GreaterRescale: return "> rescale";
+            case LessRescale: return "< rescale";
+            case AddRescale: return "+ rescale";
+            case SubRescale: return "- rescale";
+            case PlusEqRescale: return "+= rescale";
+            case MinusEqRescale: return "-= rescale";
+            case DivideWiden: return "/ widen";
+            case Overflow: return "overflow";
+            default: return "?";
+            }
+        }
+
+        // Counts summed over all threads
+        struct Snapshot
+        {
+            uint64_t m_Counts[OpCount][MaxDps][MaxDps];
+
+            Snapshot()
+            {
+                std::fill(&m_Counts[0][0][0], &m_Counts[0][0][0] + static_cast<size_t>(OpCount) * MaxDps * MaxDps, uint64_t(0));
+            }
+
+            inline uint64_t get(Op op, size_t dps1, size_t dps2) const
+            {
+                return m_Counts[op][dps1 < MaxDps ? dps1 : MaxDps - 1][dps2 < MaxDps ? dps2 : MaxDps - 1];
+            }
+
+            uint64_t total(Op op) const
+            {
+                uint64_t t = 0;
+                for (size_t a = 0; a < MaxDps; ++a)
+                    for (size_t b = 0; b < MaxDps; ++b)
+                        t += m_Counts[op][a][b];
+                return t;
+            }
+        };
+    }
+
+    namespace details
+    {
+        namespace instrument
+        {
+            // r = a op b, true if the exact result does not fit R
+#if defined(__GNUC__)
+            template <typename R, typename A, typename B>
+            inline bool add(A a, B b, R& r) { return __builtin_add_overflow(a, b, &r); }
+
+            template <typename R, typename A, typename B>
+            inline bool sub(A a, B b, R& r) { return __builtin_sub_overflow(a, b, &r); }
+
+            template <typename R, typename A, typename B>
+            inline bool mul(A a, B b, R& r) { return __builtin_mul_overflow(a, b, &r); }
+#else
+            // Without the builtins values are at most 64 bits
+            template <typename R>
+            inline bool narrow(long long v, R& r)
+            {
+                r = static_cast<R>(v);
+                return v < static_cast<long long>(std::numeric_limits<R>::min())
+                    || v > static_cast<long long>(std::numeric_limits<R>::max());
+            }
+
+            template <typename R, typename A, typename B>
+            inline bool add(A a, B b, R& r)
+            {
+                const long long x = a, y = b;
+                if (y > 0 ? x > std::numeric_limits<long long>::max() - y
+                    : x < std::numeric_limits<long long>::min() - y) return true;
+                return narrow(x + y, r);
+            }
+
+            template <typename R, typename A, typename B>
+            inline bool sub(A a, B b, R& r)
+            {
+                const long long x = a, y = b;
+                if (y < 0 ? x > std::numeric_limits<long long>::max() + y
+                    : x < std::numeric_limits<long long>::min() + y) return true;
+                return narrow(x - y, r);
+            }
+
+            template <typename R, typename A, typename B>
+            inline bool mul(A a, B b, R& r)
+            {
+                const long long x = a, y = b;
+                const long long lo = std::numeric_limits<long long>::min(), hi = std::numeric_limits<long long>::max();
+                if (x > 0 ? (y > 0 ? x > hi / y : y < lo / x) : (y > 0 ? x < lo / y : x != 0 && y < hi / x))
+                    return true;
+                return narrow(x * y, r);
+            }
+#endif
+
+            // The tests behind the Overflow hooks in fixed.h
+            template <typename R, typename V>
+            inline bool fits(V v)
+            {
+                R r;
+                return !add(v, 0, r);
+            }
+
+            template <typename R, typename A, typename B>
+            inline bool productOverflows(A a, B b)
+            {
+                R r;
+                return mul(a, b, r);
+            }
+
+            // a * fa + b * fb, or a * fa - b * fb, does not fit R
+            template <typename R, typename A, typename B>
+            inline bool sumOverflows(A a, long long fa, B b, long long fb, bool subtract)
+            {
+                R x, y, r;
+                if (mul(a, fa, x) || mul(b, fb, y)) return true;
+                return subtract ? sub(x, y, r) : add(x, y, r);
+            }
+
+            struct Block
+            {
+                std::atomic<uint64_t> m_Counts[Instrument::OpCount][Instrument::MaxDps][Instrument::MaxDps];
+
+                Block()
+                {
+                    for (size_t i = 0; i < static_cast<size_t>(Instrument::OpCount) * Instrument::MaxDps * Instrument::MaxDps; ++i)
+                        (&m_Counts[0][0][0])[i].store(0, std::memory_order_relaxed);
+                }
+
+                void addTo(Instrument::Snapshot& s) const
+                {
+                    for (size_t i = 0; i < static_cast<size_t>(Instrument::OpCount) * Instrument::MaxDps * Instrument::MaxDps; ++i)
+                        (&s.m_Counts[0][0][0])[i] += (&m_Counts[0][0][0])[i].load(std::memory_order_relaxed);
+                }
+            };
+
+            struct Registry
+            {
+                std::mutex m_Lock;
+                std::vector<Block*> m_Live;
+                Instrument::Snapshot m_Retired;  // counts of threads that have exited
+                Instrument::Snapshot m_Baseline; // totals at the last reset
+            };
+
+            // Never destroyed, threads may exit after static destruction
+            inline Registry& registry()
+            {
+                static Registry* r = new Registry;
+                return *r;
+            }
+
+            struct Local
+            {
+                Block* m_Block;
+
+                Local() : m_Block(new Block)
+                {
+                    Registry& r = registry();
+                    std::lock_guard<std::mutex> lock(r.m_Lock);
+                    r.m_Live.push_back(m_Block);
+                }
+
+                ~Local()
+                {
+                    Registry& r = registry();
+                    std::lock_guard<std::mutex> lock(r.m_Lock);
+                    m_Block->addTo(r.m_Retired);
+                    r.m_Live.erase(std::find(r.m_Live.begin(), r.m_Live.end(), m_Block));
+                    delete m_Block;
+                }
+            };
+
+            inline Block& local()
+            {
+                thread_local Local l;
+                return *l.m_Block;
+            }
+
+            inline Instrument::Snapshot totals(Registry& r)
+            {
+                Instrument::Snapshot s = r.m_Retired;
+                for (size_t i = 0; i < r.m_Live.size(); ++i)
+                    r.m_Live[i]->addTo(s);
+                return s;
+            }
+        }
+    }
+
+    namespace Instrument
+    {
+        // Called by the hooks in fixed.h, only the calling thread writes its counters
+        inline void count(Op op, size_t dps1, size_t dps2)
+        {
+            std::atomic<uint64_t>& c = details::instrument::local().m_Counts[op]
+                [dps1 < MaxDps ? dps1 : MaxDps - 1][dps2 < MaxDps ? dps2 : MaxDps - 1];
+            c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        // Counts since the last reset, over all threads
+        inline Snapshot snapshot()
+        {
+            details::instrument::Registry& r = details::instrument::registry();
+            std::lock_guard<std::mutex> lock(r.m_Lock);
+            Snapshot s = details::instrument::totals(r);
+            for (size_t i = 0; i < static_cast<size_t>(OpCount) * MaxDps * MaxDps; ++i)
+                (&s.m_Counts[0][0][0])[i] -= (&r.m_Baseline.m_Counts[0][0][0])[i];
+            return s;
+        }
+
+        // Starts counting from zero again
+        inline void reset()
+        {
+            details::instrument::Registry& r = details::instrument::registry();
+            std::lock_guard<std::mutex> lock(r.m_Lock);
+            r.m_Baseline = details::instrument::totals(r);
+        }
+
+        // Writes every non zero counter, most frequent first
+        inline void report(std::ostream& s, const Snapshot& snap)
+        {
+            struct Line { uint64_t n; int op; size_t a; size_t b; };
+            std::vector<Line> lines;
+            for (int op = 0; op < OpCount; ++op)
+                for (size_t a = 0; a < MaxDps; ++a)
+                    for (size_t b = 0; b < MaxDps; ++b)
+                        if (snap.m_Counts[op][a][b])
+                        {
+                            const Line l = { snap.m_Counts[op][a][b], op, a, b };
+                            lines.push_back(l);
+                        }
+            std::stable_sort(lines.begin(), lines.end(),
+                [](const Line& x, const Line& y) { return x.n > y.n; });
+            for (size_t i = 0; i < lines.size(); ++i)
+                s << name(static_cast<Op>(lines[i].op)) << " dps " << lines[i].a << ", "
+                  << lines[i].b << ": " << lines[i].n << "\n";
+        }
+
+        inline void report(std::ostream& s)
+        {
+            report(s, snapshot());
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef __FIXED_PARALLEL__20851739
+#define __FIXED_PARALLEL__20851739
+
+#include <cstddef> // for size_t
+#include <thread>
+#include <vector>
+
+// Minimal fork/join helpers shared by the multi-threaded bulk kernels
+namespace FixedPoint
+{
+    namespace details
+    {
+        namespace parallel
+        {
+            // Number of threads to use for n rows.
+            // requested == 0 means one per hardware thread.
+            inline size_t threadCount(size_t requested, size_t n, size_t minRowsPerThread)
+            {
+                size_t t = requested;
+                if (t == 0) t = std::thread::hardware_concurrency();
+                if (t == 0) t = 1;
+                const size_t most = n / minRowsPerThread;
+                if (t > most) t = most;
+                return t ? t : 1;
+            }
+
+            // Half open row range [begin, end) of chunk i of count
+            inline void chunk(size_t n, size_t count, size_t i, size_t& begin, size_t& end)
+            {
+                begin = n / count * i + (i < n % count ? i : n % count);
+                end = begin + n / count + (i < n % count ? 1 : 0);
+            }
+
+            // Calls f(i) for i in [0, count), chunk 0 runs on the calling thread
+            template <typename F>
+            inline void run(size_t count, F f)
+            {
+                std::vector<std::thread> workers;
+                workers.reserve(count ? count - 1 : 0);
+                for (size_t i = 1; i < count; ++i)
+                    workers.emplace_back([&f, i]() { f(i); });
+                f(0);
+                for (size_t i = 0; i < workers.size(); ++i)
+                    workers[i].join();
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,619 @@
+#ifndef __FIXED_PIPELINE__64207153
+#define __FIXED_PIPELINE__64207153
+
+#if !defined(__cpp_impl_coroutine)
+#error "fixed_pipeline.h needs C++20 coroutines"
+#endif
+
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "fixed.h"
+#include "fixed_parallel.h"
+
+// Streaming batch jobs over text files of Fixed records:
+//
+//     read -> parse -> compute -> format -> write
+//
+// Read, compute and write run on one thread each, parse and format on a
+// pool of threads each. Stages hand batches to the next through bounded
+// queues, so the stages overlap and memory stays at a few chunks whatever
+// the file size. A stage that falls behind fills its input queue and the
+// stages before it wait (backpressure). The queues after the pools put
+// batches back in file order by their seq.
+//
+// A record is one line of comma separated decimals, each parsed into a
+// Fixed<dps, T>. The compute stage gets each parsed batch to change in
+// place, the format stage writes it back out with operator<<.
+namespace FixedPoint
+{
+    namespace Pipeline
+    {
+        // Lazily produced sequence, written as a coroutine with co_yield
+        template <typename T>
+        struct Generator
+        {
+            struct promise_type
+            {
+                T* m_Current = nullptr;
+                std::exception_ptr m_Exception;
+
+                Generator get_return_object()
+                {
+                    return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+                }
+                std::suspend_always initial_suspend() noexcept { return {}; }
+                std::suspend_always final_suspend() noexcept { return {}; }
+                std::suspend_always yield_value(T& v) noexcept
+                {
+                    m_Current = std::addressof(v);
+                    return {};
+                }
+                std::suspend_always yield_value(T&& v) noexcept
+                {
+                    m_Current = std::addressof(v);
+                    return {};
+                }
+                void return_void() { }
+                void unhandled_exception() { m_Exception = std::current_exception(); }
+            };
+
+            struct iterator
+            {
+                std::coroutine_handle<promise_type> m_Handle;
+
+                iterator& operator++()
+                {
+                    m_Handle.resume();
+                    if (m_Handle.promise().m_Exception)
+                        std::rethrow_exception(m_Handle.promise().m_Exception);
+                    return *this;
+                }
+                T& operator*() const { return *m_Handle.promise().m_Current; }
+                bool operator==(std::default_sentinel_t) const { return !m_Handle || m_Handle.done(); }
+            };
+
+            explicit Generator(std::coroutine_handle<promise_type> h) : m_Handle(h) { }
+            Generator(Generator&& g) noexcept : m_Handle(std::exchange(g.m_Handle, nullptr)) { }
+            Generator(const Generator&) = delete;
+            Generator& operator=(const Generator&) = delete;
+            ~Generator() { if (m_Handle) m_Handle.destroy(); }
+
+            iterator begin()
+            {
+                iterator it = { m_Handle };
+                return ++it;
+            }
+            std::default_sentinel_t end() const { return {}; }
+
+        private:
+            std::coroutine_handle<promise_type> m_Handle;
+        };
+
+        // Fixed capacity queue between two threads. push waits while the
+        // queue is full, pop while it is empty. After close, push fails and
+        // pop fails once the queue is drained.
+        template <typename T>
+        struct BoundedQueue
+        {
+            typedef T value_type;
+
+            explicit BoundedQueue(size_t capacity) : m_Capacity(capacity ? capacity : 1), m_Closed(false) { }
+
+            bool push(T v)
+            {
+                std::unique_lock<std::mutex> lock(m_Lock);
+                m_NotFull.wait(lock, [this] { return m_Closed || m_Items.size() < m_Capacity; });
+                if (m_Closed) return false;
+                m_Items.push_back(std::move(v));
+                m_NotEmpty.notify_one();
+                return true;
+            }
+
+            bool pop(T& v)
+            {
+                std::unique_lock<std::mutex> lock(m_Lock);
+                m_NotEmpty.wait(lock, [this] { return m_Closed || !m_Items.empty(); });
+                if (m_Items.empty()) return false;
+                v = std::move(m_Items.front());
+                m_Items.pop_front();
+                m_NotFull.notify_one();
+                return true;
+            }
+
+            void close()
+            {
+                std::lock_guard<std::mutex> lock(m_Lock);
+                m_Closed = true;
+                m_NotFull.notify_all();
+                m_NotEmpty.notify_all();
+            }
+
+        private:
+            std::mutex m_Lock;
+            std::condition_variable m_NotFull;
+            std::condition_variable m_NotEmpty;
+            std::deque<T> m_Items;
+            size_t m_Capacity;
+            bool m_Closed;
+        };
+
+        // Bounded queue from several threads to one that hands items out in
+        // seq order. Every seq from 0 up is pushed exactly once. push waits
+        // while seq is capacity or more ahead of the next seq to pop, pop
+        // waits for the next seq. After close, push fails and pop fails once
+        // the next seq is missing.
+        template <typename T>
+        struct OrderedQueue
+        {
+            typedef T value_type;
+
+            explicit OrderedQueue(size_t capacity) : m_Slots(capacity ? capacity : 1), m_Next(0), m_Closed(false) { }
+
+            bool push(size_t seq, T v)
+            {
+                std::unique_lock<std::mutex> lock(m_Lock);
+                m_NotFull.wait(lock, [&] { return m_Closed || seq < m_Next + m_Slots.size(); });
+                if (m_Closed) return false;
+                m_Slots[seq % m_Slots.size()] = std::move(v);
+                if (seq == m_Next) m_NotEmpty.notify_one();
+                return true;
+            }
+
+            bool pop(T& v)
+            {
+                std::unique_lock<std::mutex> lock(m_Lock);
+                m_NotEmpty.wait(lock, [this] { return m_Closed || next().has_value(); });
+                if (!next().has_value()) return false;
+                v = std::move(*next());
+                next().reset();
+                ++m_Next;
+                m_NotFull.notify_all();
+                return true;
+            }
+
+            void close()
+            {
+                std::lock_guard<std::mutex> lock(m_Lock);
+                m_Closed = true;
+                m_NotFull.notify_all();
+                m_NotEmpty.notify_all();
+            }
+
+        private:
+            inline std::optional<T>& next() { return m_Slots[m_Next % m_Slots.size()]; }
+
+            std::mutex m_Lock;
+            std::condition_variable m_NotFull;
+            std::condition_variable m_NotEmpty;
+            std::vector<std::optional<T> > m_Slots;
+            size_t m_Next;
+            bool m_Closed;
+        };
+
+        // Whole lines of the input, in file order
+        struct Chunk
+        {
+            size_t seq;
+            std::string text;
+        };
+
+        // Parsed records of one chunk. Record i is values[offsets[i]] up to
+        // values[offsets[i + 1]]; offsets has one entry more than there are
+        // records.
+        template <size_t dps, typename T = config::DefaultType>
+        struct Batch
+        {
+            size_t seq;
+            std::vector<Fixed<dps, T> > values;
+            std::vector<size_t> offsets;
+            size_t errors; // lines that could not be parsed, dropped
+
+            inline size_t records() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+            inline Fixed<dps, T>* record(size_t i) { return values.data() + offsets[i]; }
+            inline size_t fields(size_t i) const { return offsets[i + 1] - offsets[i]; }
+        };
+
+        enum Stage { Read, Parse, Compute, Format, Write, StageCount };
+
+        inline const char* name(Stage s)
+        {
+            switch (s)
+            {
+            case Read: return "read";
+            case Parse: return "parse";
+            case Compute: return "compute";
+            case Format: return "format";
+            case Write: return "write";
+            default: return "?";
+            }
+        }
+
+        // busy and wait are summed over the stage's threads
+        struct StageStats
+        {
+            size_t threads = 0;
+            size_t batches = 0;
+            double busy = 0; // seconds doing the stage's work
+            double wait = 0; // seconds blocked on a queue
+        };
+
+        struct Report
+        {
+            bool ok = false; // input read and output written in full
+            size_t records = 0;
+            size_t errors = 0;
+            double seconds = 0;
+            StageStats stages[StageCount];
+        };
+
+        struct Options
+        {
+            std::string input;
+            std::string output;
+            size_t chunkBytes = 1 << 20; // read size, chunks are cut at line ends
+            size_t queueDepth = 4;       // batches between two stages
+            size_t workers = 0;          // parse and format threads each, 0 = one per hardware thread
+        };
+
+        // Parses a decimal such as "-12.345" from [p, end) into out. Extra
+        // decimal places are rounded half away from zero. Spaces around the
+        // number are skipped. False if the text is not a number or does not
+        // fit Fixed<dps, T>.
+        template <size_t dps, typename T>
+        inline bool parseFixed(const char* p, const char* end, Fixed<dps, T>& out)
+        {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+            while (end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) --end;
+            bool negative = false;
+            if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+
+            const unsigned long long limit = negative
+                ? static_cast<unsigned long long>(std::numeric_limits<T>::max()) + 1
+                : static_cast<unsigned long long>(std::numeric_limits<T>::max());
+            unsigned long long v = 0;
+            size_t digits = 0, decimals = 0;
+            bool point = false, roundUp = false;
+            for (; p < end; ++p)
+            {
+                if (*p == '.' && !point) { point = true; continue; }
+                if (*p < '0' || *p > '9') return false;
+                ++digits;
+                if (point && decimals >= dps)
+                {
+                    if (decimals++ == dps) roundUp = (*p >= '5');
+                    continue;
+                }
+                if (point) ++decimals;
+                const unsigned d = static_cast<unsigned>(*p - '0');
+                if (v > (limit - d) / 10) return false;
+                v = v * 10 + d;
+            }
+            if (!digits) return false;
+            for (; decimals < dps; ++decimals)
+            {
+                if (v > limit / 10) return false;
+                v *= 10;
+            }
+            if (roundUp)
+            {
+                if (v == limit) return false;
+                ++v;
+            }
+            out = Utils::MkFxd<dps, T>(negative ? static_cast<T>(0 - v) : static_cast<T>(v));
+            return true;
+        }
+    }
+
+    namespace details
+    {
+        namespace pipeline
+        {
+            typedef std::chrono::steady_clock Clock;
+
+            inline double since(Clock::time_point t)
+            {
+                return std::chrono::duration<double>(Clock::now() - t).count();
+            }
+
+            // The file in chunks of whole lines
+            inline Pipeline::Generator<Pipeline::Chunk> readChunks(std::ifstream& in, size_t chunkBytes, bool& ok)
+            {
+                std::string carry;
+                std::vector<char> buf(chunkBytes ? chunkBytes : 1);
+                size_t seq = 0;
+                while (in)
+                {
+                    in.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+                    const size_t got = static_cast<size_t>(in.gcount());
+                    if (!got) break;
+                    carry.append(buf.data(), got);
+                    const size_t cut = carry.rfind('\n');
+                    if (cut == std::string::npos) continue;
+                    Pipeline::Chunk c = { seq++, carry.substr(0, cut + 1) };
+                    carry.erase(0, cut + 1);
+                    co_yield c;
+                }
+                ok = in.eof();
+                if (!carry.empty())
+                {
+                    Pipeline::Chunk c = { seq++, std::move(carry) };
+                    co_yield c;
+                }
+            }
+
+            // Items popped from q until it is closed and empty, time blocked
+            // added to wait
+            template <typename Queue>
+            inline Pipeline::Generator<typename Queue::value_type> drain(Queue& q, double& wait)
+            {
+                typename Queue::value_type v;
+                for (;;)
+                {
+                    const Clock::time_point t = Clock::now();
+                    const bool got = q.pop(v);
+                    wait += since(t);
+                    if (!got) break;
+                    co_yield v;
+                }
+            }
+
+            template <typename Queue, typename... Args>
+            inline bool timedPush(Queue& q, double& wait, Args&&... args)
+            {
+                const Clock::time_point t = Clock::now();
+                const bool pushed = q.push(std::forward<Args>(args)...);
+                wait += since(t);
+                return pushed;
+            }
+
+            template <size_t dps, typename T>
+            inline Pipeline::Batch<dps, T> parse(Pipeline::Chunk& c)
+            {
+                Pipeline::Batch<dps, T> b;
+                b.seq = c.seq;
+                b.errors = 0;
+                b.offsets.push_back(0);
+                const char* p = c.text.data();
+                const char* end = p + c.text.size();
+                while (p < end)
+                {
+                    const char* eol = p;
+                    while (eol < end && *eol != '\n') ++eol;
+                    const size_t start = b.values.size();
+                    bool good = true;
+                    for (const char* f = p; good; )
+                    {
+                        const char* comma = f;
+                        while (comma < eol && *comma != ',') ++comma;
+                        Fixed<dps, T> v;
+                        good = Pipeline::parseFixed(f, comma, v);
+                        if (good) b.values.push_back(v);
+                        if (comma == eol) break;
+                        f = comma + 1;
+                    }
+                    if (good)
+                        b.offsets.push_back(b.values.size());
+                    else
+                    {
+                        b.values.resize(start);
+                        // blank lines are skipped, not counted
+                        const char* q = p;
+                        while (q < eol && (*q == ' ' || *q == '\t' || *q == '\r')) ++q;
+                        if (q < eol) ++b.errors;
+                    }
+                    if (eol == end) break;
+                    p = eol + 1;
+                }
+                return b;
+            }
+
+            template <size_t dps, typename T>
+            inline std::string format(Pipeline::Batch<dps, T>& b)
+            {
+                std::ostringstream s;
+                for (size_t i = 0; i < b.records(); ++i)
+                {
+                    const Fixed<dps, T>* r = b.record(i);
+                    for (size_t f = 0; f < b.fields(i); ++f)
+                    {
+                        if (f) s << ',';
+                        s << r[f];
+                    }
+                    s << '\n';
+                }
+                return s.str();
+            }
+
+            // Runs a single threaded stage: pops from in, pushes f(item) to
+            // out, then closes out. Stops early, closing in, when out has been
+            // closed.
+            template <typename InQueue, typename OutQueue, typename F>
+            inline void transform(InQueue& in, OutQueue& out, Pipeline::StageStats& st, F f)
+            {
+                for (typename InQueue::value_type& item : drain(in, st.wait))
+                {
+                    const Clock::time_point t = Clock::now();
+                    typename OutQueue::value_type o = f(item);
+                    st.busy += since(t);
+                    ++st.batches;
+                    if (!timedPush(out, st.wait, std::move(o)))
+                    {
+                        in.close();
+                        break;
+                    }
+                }
+                out.close();
+            }
+
+            // As transform, for one of the running threads of a pooled stage.
+            // Results are pushed under their item's seq and the last thread
+            // to finish closes out.
+            template <typename In, typename Out, typename F>
+            inline void transformOrdered(Pipeline::BoundedQueue<In>& in, Pipeline::OrderedQueue<Out>& out,
+                std::atomic<size_t>& running, Pipeline::StageStats& st, F f)
+            {
+                for (In& item : drain(in, st.wait))
+                {
+                    const size_t seq = item.seq;
+                    const Clock::time_point t = Clock::now();
+                    Out o = f(item);
+                    st.busy += since(t);
+                    ++st.batches;
+                    if (!timedPush(out, st.wait, seq, std::move(o)))
+                    {
+                        in.close();
+                        break;
+                    }
+                }
+                if (running.fetch_sub(1) == 1) out.close();
+            }
+        }
+    }
+
+    namespace Pipeline
+    {
+        // Streams opt.input through compute into opt.output.
+        // compute is called as compute(Batch<dps, T>&), one batch at a time
+        // and in file order, on the compute stage's thread. An exception
+        // thrown by a stage stops the pipeline and is rethrown here.
+        template <size_t dps, typename T = config::DefaultType, typename F>
+        inline Report run(const Options& opt, F compute)
+        {
+            using namespace details::pipeline;
+            Report r;
+            const Clock::time_point start = Clock::now();
+            std::ifstream in(opt.input, std::ios::binary);
+            std::ofstream out(opt.output, std::ios::binary | std::ios::trunc);
+            if (!in || !out) return r;
+
+            size_t workers = opt.workers ? opt.workers : std::thread::hardware_concurrency();
+            if (!workers) workers = 1;
+
+            BoundedQueue<Chunk> chunks(opt.queueDepth);
+            OrderedQueue<Batch<dps, T> > parsed(opt.queueDepth);
+            BoundedQueue<Batch<dps, T> > computed(opt.queueDepth);
+            OrderedQueue<std::string> formatted(opt.queueDepth);
+            std::atomic<size_t> parsing(workers), formatting(workers);
+
+            // Threads 0 to 2 read, compute and write, then workers parse and
+            // workers format
+            const size_t threads = 3 + 2 * workers;
+            auto stage = [&](size_t i)
+            {
+                return i == 0 ? Read : i == 1 ? Compute : i == 2 ? Write : i < 3 + workers ? Parse : Format;
+            };
+            std::vector<StageStats> stats(threads);
+            std::vector<std::exception_ptr> failed(threads);
+
+            bool readOk = false, writeOk = true;
+            auto guard = [&](size_t i, auto body)
+            {
+                try { body(); }
+                catch (...)
+                {
+                    failed[i] = std::current_exception();
+                    chunks.close(); parsed.close(); computed.close(); formatted.close();
+                }
+            };
+
+            details::parallel::run(threads, [&](size_t i)
+            {
+                StageStats& st = stats[i];
+                switch (stage(i))
+                {
+                case Read:
+                    guard(i, [&]
+                    {
+                        Clock::time_point t = Clock::now();
+                        for (Chunk& c : readChunks(in, opt.chunkBytes, readOk))
+                        {
+                            st.busy += since(t);
+                            ++st.batches;
+                            if (!timedPush(chunks, st.wait, std::move(c))) { readOk = false; break; }
+                            t = Clock::now();
+                        }
+                        chunks.close();
+                    });
+                    break;
+                case Parse:
+                    guard(i, [&] { transformOrdered(chunks, parsed, parsing, st,
+                        [](Chunk& c) { return parse<dps, T>(c); }); });
+                    break;
+                case Compute:
+                    guard(i, [&] { transform(parsed, computed, st, [&](Batch<dps, T>& b)
+                    {
+                        compute(b);
+                        r.records += b.records();
+                        r.errors += b.errors;
+                        return std::move(b);
+                    }); });
+                    break;
+                case Format:
+                    guard(i, [&] { transformOrdered(computed, formatted, formatting, st,
+                        [](Batch<dps, T>& b) { return format(b); }); });
+                    break;
+                case Write:
+                    guard(i, [&]
+                    {
+                        for (std::string& text : drain(formatted, st.wait))
+                        {
+                            const Clock::time_point t = Clock::now();
+                            out.write(text.data(), static_cast<std::streamsize>(text.size()));
+                            st.busy += since(t);
+                            ++st.batches;
+                            if (!out) { writeOk = false; formatted.close(); break; }
+                        }
+                        out.flush();
+                        writeOk = writeOk && static_cast<bool>(out);
+                    });
+                    break;
+                default:
+                    break;
+                }
+            });
+
+            for (size_t i = 0; i < threads; ++i)
+            {
+                if (failed[i]) std::rethrow_exception(failed[i]);
+                StageStats& st = r.stages[stage(i)];
+                ++st.threads;
+                st.batches += stats[i].batches;
+                st.busy += stats[i].busy;
+                st.wait += stats[i].wait;
+            }
+            r.ok = readOk && writeOk;
+            r.seconds = since(start);
+            return r;
+        }
+
+        // One line per stage: threads, batches, busy and blocked time
+        inline void report(std::ostream& s, const Report& r)
+        {
+            s << r.records << " records, " << r.errors << " bad lines, " << r.seconds << " s\n";
+            for (int i = 0; i < StageCount; ++i)
+                s << name(static_cast<Stage>(i)) << ": " << r.stages[i].threads << " threads, "
+                  << r.stages[i].batches << " batches, busy " << r.stages[i].busy << " s, waiting "
+                  << r.stages[i].wait << " s\n";
+        }
+    }
+}
+
+#endif
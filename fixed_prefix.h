@@ -0,0 +1,320 @@
+#ifndef __FIXED_PREFIX__58204631
+#define __FIXED_PREFIX__58204631
+
+#include <cstddef> // for size_t
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "fixed.h"
+#include "fixed_arith.h"
+#include "fixed_dispatch.h"
+#include "fixed_parallel.h"
+#include "fixed_scan.h"
+
+// Running totals (prefix sums) over columns of Fixed values.
+// Two pass blocked scan: every thread sums its block, the block totals are
+// scanned serially, then every thread scans its block again starting from
+// its offset. Output can be a wider type than the input, e.g. a
+// Fixed<2, int> ledger into Fixed<2, long long> balances. int and long long
+// columns summed into long long use the SIMD level picked by fixed_dispatch.h.
+namespace FixedPoint
+{
+    namespace details
+    {
+        namespace prefix
+        {
+            // Scans n values starting from carry, returns the carry out.
+            // Arithmetic wraps like the unsigned type, overflow is not detected.
+            // Safe in place when T and OutT are the same size.
+            template <typename T, typename OutT, bool exclusive>
+            inline OutT blockScanScalar(const T* in, size_t n, OutT* out, OutT carry)
+            {
+                typedef typename std::make_unsigned<OutT>::type U;
+                U c = static_cast<U>(carry);
+                for (size_t i = 0; i < n; ++i)
+                {
+                    const U v = static_cast<U>(static_cast<OutT>(in[i]));
+                    c += v;
+                    out[i] = static_cast<OutT>(exclusive ? c - v : c);
+                }
+                return static_cast<OutT>(c);
+            }
+
+#if FIXEDPOINT_X86
+            FIXEDPOINT_TARGET("sse4.2")
+            inline __m128i load2(const long long* in)
+            {
+                return _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+            }
+
+            FIXEDPOINT_TARGET("sse4.2")
+            inline __m128i load2(const int* in)
+            {
+                return _mm_cvtepi32_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in)));
+            }
+
+            template <typename T, bool exclusive>
+            FIXEDPOINT_TARGET("sse4.2")
+            inline long long blockScanSse42(const T* in, size_t n, long long* out, long long carry)
+            {
+                __m128i c = _mm_set1_epi64x(carry);
+                size_t i = 0;
+                for (; i + 2 <= n; i += 2)
+                {
+                    const __m128i v = load2(in + i);
+                    // [a, b] -> [a, a+b]
+                    __m128i x = _mm_add_epi64(v, _mm_slli_si128(v, 8));
+                    x = _mm_add_epi64(x, c);
+                    c = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 2, 3, 2));
+                    if (exclusive) x = _mm_sub_epi64(x, v);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), x);
+                }
+                return blockScanScalar<T, long long, exclusive>(in + i, n - i, out + i, _mm_cvtsi128_si64(c));
+            }
+
+            FIXEDPOINT_TARGET("avx2")
+            inline __m256i load4(const long long* in)
+            {
+                return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+            }
+
+            FIXEDPOINT_TARGET("avx2")
+            inline __m256i load4(const int* in)
+            {
+                return _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in)));
+            }
+
+            template <typename T, bool exclusive>
+            FIXEDPOINT_TARGET("avx2")
+            inline long long blockScanAvx2(const T* in, size_t n, long long* out, long long carry)
+            {
+                const __m256i zero = _mm256_setzero_si256();
+                __m256i c = _mm256_set1_epi64x(carry);
+                size_t i = 0;
+                for (; i + 4 <= n; i += 4)
+                {
+                    const __m256i v = load4(in + i);
+                    // [a, b, c, d] -> [a, a+b, a+b+c, a+b+c+d]
+                    __m256i x = _mm256_add_epi64(v, _mm256_blend_epi32(
+                        _mm256_permute4x64_epi64(v, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x03));
+                    x = _mm256_add_epi64(x, _mm256_blend_epi32(
+                        _mm256_permute4x64_epi64(x, _MM_SHUFFLE(1, 0, 0, 0)), zero, 0x0F));
+                    x = _mm256_add_epi64(x, c);
+                    c = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(3, 3, 3, 3));
+                    if (exclusive) x = _mm256_sub_epi64(x, v);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), x);
+                }
+                return blockScanScalar<T, long long, exclusive>(in + i, n - i, out + i,
+                    _mm_cvtsi128_si64(_mm256_castsi256_si128(c)));
+            }
+
+            FIXEDPOINT_TARGET("avx512f")
+            inline __m512i load8(const long long* in)
+            {
+                return _mm512_loadu_si512(in);
+            }
+
+            FIXEDPOINT_TARGET("avx512f")
+            inline __m512i load8(const int* in)
+            {
+                return _mm512_maskz_cvtepi32_epi64(0xFF, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in)));
+            }
+
+            template <typename T, bool exclusive>
+            FIXEDPOINT_TARGET("avx512f")
+            inline long long blockScanAvx512(const T* in, size_t n, long long* out, long long carry)
+            {
+                // lane i takes lane i - 1, i - 2, i - 4, lower lanes are zeroed.
+                // The unmasked permute, widen and cast forms start from an
+                // undefined register, which GCC reports as maybe-uninitialized;
+                // their all-lanes maskz forms compile to the same instructions.
+                const __m512i by1 = _mm512_set_epi64(6, 5, 4, 3, 2, 1, 0, 0);
+                const __m512i by2 = _mm512_set_epi64(5, 4, 3, 2, 1, 0, 0, 0);
+                const __m512i by4 = _mm512_set_epi64(3, 2, 1, 0, 0, 0, 0, 0);
+                const __m512i last = _mm512_set1_epi64(7);
+                __m512i c = _mm512_set1_epi64(carry);
+                size_t i = 0;
+                for (; i + 8 <= n; i += 8)
+                {
+                    const __m512i v = load8(in + i);
+                    __m512i x = _mm512_add_epi64(v, _mm512_maskz_permutexvar_epi64(0xFE, by1, v));
+                    x = _mm512_add_epi64(x, _mm512_maskz_permutexvar_epi64(0xFC, by2, x));
+                    x = _mm512_add_epi64(x, _mm512_maskz_permutexvar_epi64(0xF0, by4, x));
+                    x = _mm512_add_epi64(x, c);
+                    c = _mm512_maskz_permutexvar_epi64(0xFF, last, x);
+                    if (exclusive) x = _mm512_sub_epi64(x, v);
+                    _mm512_storeu_si512(out + i, x);
+                }
+                return blockScanScalar<T, long long, exclusive>(in + i, n - i, out + i,
+                    _mm_cvtsi128_si64(_mm512_maskz_extracti32x4_epi32(0xF, c, 0)));
+            }
+#endif
+
+            template <typename T, typename OutT, bool exclusive>
+            struct blockScan
+            {
+                inline static OutT f(const T* in, size_t n, OutT* out, OutT carry)
+                {
+                    return blockScanScalar<T, OutT, exclusive>(in, n, out, carry);
+                }
+            };
+
+            // int and long long into long long pick a kernel for the active Dispatch::Level
+            template <typename T, bool exclusive>
+            struct blockScanDispatch
+            {
+                typedef long long (*Kernel)(const T*, size_t, long long*, long long);
+
+                inline static long long f(const T* in, size_t n, long long* out, long long carry)
+                {
+#if FIXEDPOINT_X86
+                    static const Kernel kernels[Dispatch::LevelCount] =
+                    {
+                        &blockScanScalar<T, long long, exclusive>,
+                        &blockScanSse42<T, exclusive>,
+                        &blockScanAvx2<T, exclusive>,
+                        &blockScanAvx512<T, exclusive>
+                    };
+                    return kernels[Dispatch::level()](in, n, out, carry);
+#else
+                    return blockScanScalar<T, long long, exclusive>(in, n, out, carry);
+#endif
+                }
+            };
+
+            template <bool exclusive>
+            struct blockScan < int, long long int, exclusive > : blockScanDispatch<int, exclusive> { };
+
+            template <bool exclusive>
+            struct blockScan < long long int, long long int, exclusive > : blockScanDispatch<long long int, exclusive> { };
+
+            template <typename OutT, typename Acc>
+            inline bool fits(Acc v)
+            {
+                return v >= static_cast<Acc>(std::numeric_limits<OutT>::min())
+                    && v <= static_cast<Acc>(std::numeric_limits<OutT>::max());
+            }
+
+            // As blockScan, stops at the first row whose running total does not
+            // fit in OutT and returns its offset (n if there was none).
+            // An exclusive row holds the total before in[i], so an overflow
+            // adding in[i] first shows in row i + 1.
+            template <typename T, typename OutT, bool exclusive>
+            inline size_t checkedBlockScan(const T* in, size_t n, OutT* out, OutT carry)
+            {
+                for (size_t i = 0; i < n; ++i)
+                {
+                    const T v = in[i];
+                    OutT next;
+#if defined(__GNUC__)
+                    const bool overflow = __builtin_add_overflow(carry, v, &next);
+#else
+                    // accumulate<OutT> is no wider than OutT without __int128, so
+                    // check the sum in the wider of the two before forming it
+                    typedef typename wider::widest<OutT, T>::type Wide;
+                    const Wide a = carry, b = v;
+                    bool overflow = b > 0 ? a > std::numeric_limits<Wide>::max() - b
+                        : a < std::numeric_limits<Wide>::min() - b;
+                    if (!overflow) overflow = !fits<OutT>(static_cast<Wide>(a + b));
+                    next = overflow ? carry : static_cast<OutT>(a + b);
+#endif
+                    if (exclusive) out[i] = carry;
+                    if (overflow) return exclusive ? i + 1 : i;
+                    if (!exclusive) out[i] = next;
+                    carry = next;
+                }
+                return n;
+            }
+
+            template <bool exclusive, bool checked, size_t dps, typename T, typename OutT>
+            size_t scan(const Fixed<dps, T>* col, size_t n, Fixed<dps, OutT>* outCol, size_t threads)
+            {
+                typedef typename wider::accumulate<T>::type Acc;
+                const T* in = details::scan::raw(col);
+                OutT* out = details::scan::raw(outCol);
+
+                // Without __int128 the block totals of a 64-bit T can overflow Acc,
+                // so checked scans of one run on a single thread
+                const size_t count = (checked && sizeof(Acc) <= sizeof(T)) ? 1
+                    : parallel::threadCount(threads, n, 1 << 16);
+                std::vector<Acc> offsets(count, 0);
+                if (count > 1)
+                {
+                    parallel::run(count, [&](size_t t)
+                    {
+                        size_t begin, end;
+                        parallel::chunk(n, count, t, begin, end);
+                        offsets[t] = arith::sum(in + begin, end - begin);
+                    });
+                    Acc running = 0;
+                    for (size_t t = 0; t < count; ++t)
+                    {
+                        const Acc s = offsets[t];
+                        offsets[t] = running;
+                        running += s;
+                    }
+                }
+
+                std::vector<size_t> stopped(count, n);
+                parallel::run(count, [&](size_t t)
+                {
+                    size_t begin, end;
+                    parallel::chunk(n, count, t, begin, end);
+                    if (!checked)
+                        blockScan<T, OutT, exclusive>::f(in + begin, end - begin, out + begin,
+                            static_cast<OutT>(offsets[t]));
+                    else if (!fits<OutT>(offsets[t]))
+                        stopped[t] = begin;
+                    else
+                    {
+                        const size_t at = checkedBlockScan<T, OutT, exclusive>(in + begin, end - begin,
+                            out + begin, static_cast<OutT>(offsets[t]));
+                        if (at < end - begin) stopped[t] = begin + at;
+                    }
+                });
+
+                size_t first = n;
+                for (size_t t = 0; t < count; ++t)
+                    if (stopped[t] < first) first = stopped[t];
+                return first;
+            }
+        }
+    }
+
+    namespace Bulk
+    {
+        // out[i] = in[0] + ... + in[i]
+        // in and out may be the same column. threads == 0 uses one per hardware thread.
+        template <size_t dps, typename T, typename OutT>
+        inline void inclusiveScan(const Fixed<dps, T>* in, size_t n, Fixed<dps, OutT>* out, size_t threads = 0)
+        {
+            details::prefix::scan<false, false>(in, n, out, threads);
+        }
+
+        // out[i] = in[0] + ... + in[i - 1], out[0] = 0
+        template <size_t dps, typename T, typename OutT>
+        inline void exclusiveScan(const Fixed<dps, T>* in, size_t n, Fixed<dps, OutT>* out, size_t threads = 0)
+        {
+            details::prefix::scan<true, false>(in, n, out, threads);
+        }
+
+        // As inclusiveScan, returns the first row whose running total does not
+        // fit in OutT, or n if none. Rows from there on are left unspecified.
+        template <size_t dps, typename T, typename OutT>
+        inline size_t checkedInclusiveScan(const Fixed<dps, T>* in, size_t n, Fixed<dps, OutT>* out, size_t threads = 0)
+        {
+            return details::prefix::scan<false, true>(in, n, out, threads);
+        }
+
+        // As exclusiveScan, returns the first row whose running total does not
+        // fit in OutT, or n if none. Rows from there on are left unspecified.
+        template <size_t dps, typename T, typename OutT>
+        inline size_t checkedExclusiveScan(const Fixed<dps, T>* in, size_t n, Fixed<dps, OutT>* out, size_t threads = 0)
+        {
+            return details::prefix::scan<true, true>(in, n, out, threads);
+        }
+    }
+}
+
+#endif
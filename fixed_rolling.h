@@ -0,0 +1,285 @@
+#ifndef __FIXED_ROLLING__47120593
+#define __FIXED_ROLLING__47120593
+
+#include <cstddef> // for size_t
+#include <vector>
+
+#include "fixed.h"
+#include "fixed_arith.h"
+
+// Rolling window statistics over streams of Fixed values.
+// Running sums of value, value * volume, volume and value^2 are kept as exact
+// wide integers, so push and pop are O(1) and the window is never re-scanned.
+// The sums are __int128 where the compiler has it. Without it they fall back
+// to long long and are no longer safe for ordinary prices: variance forms
+// n * sum(value^2), which overflows once n * |raw value| passes about 3e9,
+// e.g. 3000 values of 100.0000 at dps 4.
+namespace FixedPoint
+{
+    namespace Stats
+    {
+        enum class Rounding
+        {
+            HalfAwayFromZero, // same as the Fixed operators
+            HalfEven,
+            TowardZero
+        };
+    }
+
+    namespace details
+    {
+        namespace rolling
+        {
+            typedef wider::accumulate<long long int>::type Acc;
+
+            // num / den at 10^shift, den > 0
+            inline Acc divRound(Acc num, Acc den, int shift, Stats::Rounding mode)
+            {
+                if (shift > 0) num *= arith::pow10<Acc>(static_cast<size_t>(shift));
+                else if (shift < 0) den *= arith::pow10<Acc>(static_cast<size_t>(-shift));
+                if (mode == Stats::Rounding::HalfAwayFromZero) return arith::divRound(num, den);
+
+                Acc q = num / den;
+                const Acc r = num % den;
+                if (r == 0 || mode == Stats::Rounding::TowardZero) return q;
+
+                const Acc twice = (r < 0 ? -r : r) * 2;
+                const bool up = (twice > den) || (twice == den && (q % 2) != 0);
+                if (up) q += (num < 0) ? -1 : 1;
+                return q;
+            }
+
+            // Ring buffer growing in powers of two
+            template <typename Entry>
+            struct Ring
+            {
+                std::vector<Entry> m_Data;
+                size_t m_Head;
+                size_t m_Size;
+
+                Ring() : m_Data(16), m_Head(0), m_Size(0) { }
+
+                inline void push(const Entry& e)
+                {
+                    if (m_Size == m_Data.size())
+                    {
+                        std::vector<Entry> bigger(m_Data.size() * 2);
+                        for (size_t i = 0; i < m_Size; ++i) bigger[i] = at(i);
+                        m_Data.swap(bigger);
+                        m_Head = 0;
+                    }
+                    m_Data[(m_Head + m_Size) & (m_Data.size() - 1)] = e;
+                    ++m_Size;
+                }
+
+                inline Entry pop()
+                {
+                    const Entry e = m_Data[m_Head];
+                    m_Head = (m_Head + 1) & (m_Data.size() - 1);
+                    --m_Size;
+                    return e;
+                }
+
+                inline const Entry& at(size_t i) const
+                {
+                    return m_Data[(m_Head + i) & (m_Data.size() - 1)];
+                }
+            };
+
+            // Exact running sums shared by the window types
+            template <size_t dps, typename T, size_t vdps, typename V>
+            struct Sums
+            {
+                size_t m_Count;
+                Acc m_Value;
+                Acc m_Volume;
+                Acc m_ValueVolume;
+                Acc m_ValueSq;
+
+                Sums() : m_Count(0), m_Value(0), m_Volume(0), m_ValueVolume(0), m_ValueSq(0) { }
+
+                inline void add(T v, V w)
+                {
+                    ++m_Count;
+                    m_Value += v;
+                    m_Volume += w;
+                    m_ValueVolume += static_cast<Acc>(v) * w;
+                    m_ValueSq += static_cast<Acc>(v) * v;
+                }
+
+                inline void remove(T v, V w)
+                {
+                    --m_Count;
+                    m_Value -= v;
+                    m_Volume -= w;
+                    m_ValueVolume -= static_cast<Acc>(v) * w;
+                    m_ValueSq -= static_cast<Acc>(v) * v;
+                }
+
+                template <size_t outDps>
+                inline Fixed<outDps, T> mean(Stats::Rounding mode) const
+                {
+                    if (!m_Count) return Fixed<outDps, T>();
+                    return Utils::MkFxd<outDps>(static_cast<T>(divRound(m_Value,
+                        static_cast<Acc>(m_Count), static_cast<int>(outDps) - static_cast<int>(dps), mode)));
+                }
+
+                template <size_t outDps>
+                inline Fixed<outDps, T> vwap(Stats::Rounding mode) const
+                {
+                    // sum(v * w) is at dps + vdps, sum(w) is at vdps
+                    if (m_Volume == 0) return Fixed<outDps, T>();
+                    const Acc num = (m_Volume < 0) ? -m_ValueVolume : m_ValueVolume;
+                    const Acc den = (m_Volume < 0) ? -m_Volume : m_Volume;
+                    return Utils::MkFxd<outDps>(static_cast<T>(divRound(num, den,
+                        static_cast<int>(outDps) - static_cast<int>(dps), mode)));
+                }
+
+                // Population variance: (n * sum(v^2) - sum(v)^2) / n^2 at 2 * dps
+                template <size_t outDps>
+                inline Fixed<outDps, T> variance(Stats::Rounding mode) const
+                {
+                    if (!m_Count) return Fixed<outDps, T>();
+                    const Acc n = static_cast<Acc>(m_Count);
+                    return Utils::MkFxd<outDps>(static_cast<T>(divRound(n * m_ValueSq - m_Value * m_Value,
+                        n * n, static_cast<int>(outDps) - 2 * static_cast<int>(dps), mode)));
+                }
+            };
+        }
+    }
+
+    namespace Stats
+    {
+        // Window over the last `capacity` values pushed.
+        // Volume defaults to 1 per value when only prices are pushed.
+        template <size_t dps, typename T = config::DefaultType, size_t vdps = 0, typename V = config::DefaultType>
+        struct RollingWindow
+        {
+            struct Entry
+            {
+                T value;
+                V volume;
+            };
+
+            explicit RollingWindow(size_t capacity) : m_Capacity(capacity ? capacity : 1) { }
+
+            // Adds a value, evicting the oldest once the window is full
+            template <size_t dps2, typename T2, size_t vdps2, typename V2>
+            inline void push(const Fixed<dps2, T2>& value, const Fixed<vdps2, V2>& volume)
+            {
+                if (m_Ring.m_Size == m_Capacity) pop();
+                const Entry e = { Fixed<dps, T>(value).m_Value, Fixed<vdps, V>(volume).m_Value };
+                m_Ring.push(e);
+                m_Sums.add(e.value, e.volume);
+            }
+
+            template <size_t dps2, typename T2>
+            inline void push(const Fixed<dps2, T2>& value)
+            {
+                push(value, Fixed<vdps, V>(V(1)));
+            }
+
+            // Removes the oldest value
+            inline void pop()
+            {
+                if (!m_Ring.m_Size) return;
+                const Entry e = m_Ring.pop();
+                m_Sums.remove(e.value, e.volume);
+            }
+
+            inline size_t size() const { return m_Ring.m_Size; }
+            inline size_t capacity() const { return m_Capacity; }
+
+            template <size_t outDps = dps>
+            inline Fixed<outDps, T> mean(Rounding mode = Rounding::HalfAwayFromZero) const
+            {
+                return m_Sums.template mean<outDps>(mode);
+            }
+
+            template <size_t outDps = dps>
+            inline Fixed<outDps, T> vwap(Rounding mode = Rounding::HalfAwayFromZero) const
+            {
+                return m_Sums.template vwap<outDps>(mode);
+            }
+
+            template <size_t outDps = dps>
+            inline Fixed<outDps, T> variance(Rounding mode = Rounding::HalfAwayFromZero) const
+            {
+                return m_Sums.template variance<outDps>(mode);
+            }
+
+        private:
+            size_t m_Capacity;
+            details::rolling::Ring<Entry> m_Ring;
+            details::rolling::Sums<dps, T, vdps, V> m_Sums;
+        };
+
+        // Window over the values whose time lies in (now - span, now],
+        // where now is the time of the latest push. Times must not decrease.
+        template <size_t dps, typename T = config::DefaultType, size_t vdps = 0, typename V = config::DefaultType>
+        struct TimedRollingWindow
+        {
+            struct Entry
+            {
+                long long int time;
+                T value;
+                V volume;
+            };
+
+            explicit TimedRollingWindow(long long int span) : m_Span(span) { }
+
+            template <size_t dps2, typename T2, size_t vdps2, typename V2>
+            inline void push(long long int time, const Fixed<dps2, T2>& value, const Fixed<vdps2, V2>& volume)
+            {
+                const Entry e = { time, Fixed<dps, T>(value).m_Value, Fixed<vdps, V>(volume).m_Value };
+                m_Ring.push(e);
+                m_Sums.add(e.value, e.volume);
+                expire(time);
+            }
+
+            template <size_t dps2, typename T2>
+            inline void push(long long int time, const Fixed<dps2, T2>& value)
+            {
+                push(time, value, Fixed<vdps, V>(V(1)));
+            }
+
+            // Drops values that have fallen out of the window at time now
+            inline void expire(long long int now)
+            {
+                while (m_Ring.m_Size && m_Ring.at(0).time <= now - m_Span)
+                {
+                    const Entry e = m_Ring.pop();
+                    m_Sums.remove(e.value, e.volume);
+                }
+            }
+
+            inline size_t size() const { return m_Ring.m_Size; }
+            inline long long int span() const { return m_Span; }
+
+            template <size_t outDps = dps>
+            inline Fixed<outDps, T> mean(Rounding mode = Rounding::HalfAwayFromZero) const
+            {
+                return m_Sums.template mean<outDps>(mode);
+            }
+
+            template <size_t outDps = dps>
+            inline Fixed<outDps, T> vwap(Rounding mode = Rounding::HalfAwayFromZero) const
+            {
+                return m_Sums.template vwap<outDps>(mode);
+            }
+
+            template <size_t outDps = dps>
+            inline Fixed<outDps, T> variance(Rounding mode = Rounding::HalfAwayFromZero) const
+            {
+                return m_Sums.template variance<outDps>(mode);
+            }
+
+        private:
+            long long int m_Span;
+            details::rolling::Ring<Entry> m_Ring;
+            details::rolling::Sums<dps, T, vdps, V> m_Sums;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,542 @@
+#ifndef __FIXED_SCAN__61730452
+#define __FIXED_SCAN__61730452
+
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "fixed.h"
+#include "fixed_dispatch.h"
+
+// Predicate scans over columns of Fixed values.
+// The comparison constant is rescaled to the column's dps once, every
+// predicate is reduced to an inclusive range of raw m_Value's and the
+// column is then compared lane by lane without any further rescaling.
+// Results are written as bitmaps (bit i of word i/64 is row i, unused bits
+// of the last word are zero) or as selection vectors of row indices.
+// int and long long columns use the SIMD level picked by fixed_dispatch.h.
+namespace FixedPoint
+{
+    namespace details
+    {
+        namespace bits
+        {
+            inline int popcount64(uint64_t w)
+            {
+#if defined(__GNUC__)
+                return __builtin_popcountll(w);
+#else
+                int c = 0;
+                for (; w; w &= w - 1) ++c;
+                return c;
+#endif
+            }
+
+            inline int ctz64(uint64_t w)
+            {
+#if defined(__GNUC__)
+                return __builtin_ctzll(w);
+#else
+                int c = 0;
+                while (!(w & 1)) { w >>= 1; ++c; }
+                return c;
+#endif
+            }
+        }
+
+        namespace scan
+        {
+            // 10^k, k must be < 20
+            inline unsigned long long pow10(size_t k)
+            {
+                unsigned long long f = 1;
+                while (k--) f *= 10;
+                return f;
+            }
+
+            // A raw threshold that may lie outside the range of long long.
+            // sat < 0: below every long long, sat > 0: above every long long
+            struct Bound
+            {
+                int sat;
+                long long v;
+            };
+
+            inline Bound plusOne(Bound b)
+            {
+                if (b.sat == 0 && b.v == std::numeric_limits<long long>::max()) b.sat = 1;
+                else if (b.sat == 0) ++b.v;
+                return b;
+            }
+
+            inline Bound minusOne(Bound b)
+            {
+                if (b.sat == 0 && b.v == std::numeric_limits<long long>::min()) b.sat = -1;
+                else if (b.sat == 0) --b.v;
+                return b;
+            }
+
+            // floor / ceil of c / 10^(dpsC - dps), or c * 10^(dps - dpsC)
+            // when the constant has fewer dps than the column.
+            inline Bound threshold(long long c, size_t dpsC, size_t dps, bool ceil)
+            {
+                Bound b = { 0, 0 };
+                if (dpsC >= dps)
+                {
+                    if (dpsC - dps >= 19) { b.v = (c > 0) ? (ceil ? 1 : 0) : (c < 0 ? (ceil ? 0 : -1) : 0); return b; }
+                    const long long f = static_cast<long long>(pow10(dpsC - dps));
+                    long long q = c / f;
+                    const long long r = c % f;
+                    if (ceil && r > 0) ++q;
+                    if (!ceil && r < 0) --q;
+                    b.v = q;
+                    return b;
+                }
+
+                if (c == 0) return b;
+                if (dps - dpsC >= 19) { b.sat = (c > 0) ? 1 : -1; return b; }
+                const long long f = static_cast<long long>(pow10(dps - dpsC));
+                if (c > std::numeric_limits<long long>::max() / f) b.sat = 1;
+                else if (c < std::numeric_limits<long long>::min() / f) b.sat = -1;
+                else b.v = c * f;
+                return b;
+            }
+
+            template <typename T>
+            inline bool belowMin(const Bound& b)
+            {
+                return b.sat < 0 || (b.sat == 0 &&
+                    b.v < static_cast<long long>(std::numeric_limits<T>::min()));
+            }
+
+            template <typename T>
+            inline bool aboveMax(const Bound& b)
+            {
+                return b.sat > 0 || (b.sat == 0 &&
+                    b.v > static_cast<long long>(std::numeric_limits<T>::max()));
+            }
+
+            // Unsigned range test, one compare per lane: lo <= v <= hi
+            template <typename T>
+            inline bool inRange(T v, T lo, T width)
+            {
+                typedef typename std::make_unsigned<T>::type U;
+                return static_cast<U>(static_cast<U>(v) - static_cast<U>(lo))
+                    <= static_cast<U>(width);
+            }
+
+            template <typename T>
+            inline uint64_t rangeWordScalar(const T* v, size_t m, T lo, T hi)
+            {
+                typedef typename std::make_unsigned<T>::type U;
+                const T width = static_cast<T>(static_cast<U>(hi) - static_cast<U>(lo));
+                uint64_t word = 0;
+                for (size_t j = 0; j < m; ++j)
+                    word |= static_cast<uint64_t>(inRange(v[j], lo, width)) << j;
+                return word;
+            }
+
+            // Fills whole 64 row words, returns the number of rows selected
+            template <typename T>
+            inline size_t rangeWordsScalar(const T* v, size_t words, T lo, T hi, uint64_t* bits)
+            {
+                size_t count = 0;
+                for (size_t w = 0; w < words; ++w, v += 64)
+                {
+                    bits[w] = rangeWordScalar(v, 64, lo, hi);
+                    count += bits::popcount64(bits[w]);
+                }
+                return count;
+            }
+
+#if FIXEDPOINT_X86
+            FIXEDPOINT_TARGET("sse4.2,popcnt")
+            inline size_t rangeWordsSse42(const long long* v, size_t words, long long lo, long long hi, uint64_t* bits)
+            {
+                const __m128i vlo = _mm_set1_epi64x(lo);
+                const __m128i vhi = _mm_set1_epi64x(hi);
+                size_t count = 0;
+                for (size_t w = 0; w < words; ++w, v += 64)
+                {
+                    uint64_t word = 0;
+                    for (size_t j = 0; j < 64; j += 2)
+                    {
+                        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + j));
+                        const __m128i out = _mm_or_si128(
+                            _mm_cmpgt_epi64(vlo, x), _mm_cmpgt_epi64(x, vhi));
+                        const unsigned m = ~_mm_movemask_pd(_mm_castsi128_pd(out)) & 0x3u;
+                        word |= static_cast<uint64_t>(m) << j;
+                    }
+                    bits[w] = word;
+                    count += bits::popcount64(word);
+                }
+                return count;
+            }
+
+            FIXEDPOINT_TARGET("sse4.2,popcnt")
+            inline size_t rangeWordsSse42(const int* v, size_t words, int lo, int hi, uint64_t* bits)
+            {
+                const __m128i vlo = _mm_set1_epi32(lo);
+                const __m128i vhi = _mm_set1_epi32(hi);
+                size_t count = 0;
+                for (size_t w = 0; w < words; ++w, v += 64)
+                {
+                    uint64_t word = 0;
+                    for (size_t j = 0; j < 64; j += 4)
+                    {
+                        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + j));
+                        const __m128i out = _mm_or_si128(
+                            _mm_cmpgt_epi32(vlo, x), _mm_cmpgt_epi32(x, vhi));
+                        const unsigned m = ~_mm_movemask_ps(_mm_castsi128_ps(out)) & 0xFu;
+                        word |= static_cast<uint64_t>(m) << j;
+                    }
+                    bits[w] = word;
+                    count += bits::popcount64(word);
+                }
+                return count;
+            }
+
+            FIXEDPOINT_TARGET("avx2,popcnt")
+            inline size_t rangeWordsAvx2(const long long* v, size_t words, long long lo, long long hi, uint64_t* bits)
+            {
+                const __m256i vlo = _mm256_set1_epi64x(lo);
+                const __m256i vhi = _mm256_set1_epi64x(hi);
+                size_t count = 0;
+                for (size_t w = 0; w < words; ++w, v += 64)
+                {
+                    uint64_t word = 0;
+                    for (size_t j = 0; j < 64; j += 4)
+                    {
+                        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + j));
+                        const __m256i out = _mm256_or_si256(
+                            _mm256_cmpgt_epi64(vlo, x), _mm256_cmpgt_epi64(x, vhi));
+                        const unsigned m = ~_mm256_movemask_pd(_mm256_castsi256_pd(out)) & 0xFu;
+                        word |= static_cast<uint64_t>(m) << j;
+                    }
+                    bits[w] = word;
+                    count += bits::popcount64(word);
+                }
+                return count;
+            }
+
+            FIXEDPOINT_TARGET("avx2,popcnt")
+            inline size_t rangeWordsAvx2(const int* v, size_t words, int lo, int hi, uint64_t* bits)
+            {
+                const __m256i vlo = _mm256_set1_epi32(lo);
+                const __m256i vhi = _mm256_set1_epi32(hi);
+                size_t count = 0;
+                for (size_t w = 0; w < words; ++w, v += 64)
+                {
+                    uint64_t word = 0;
+                    for (size_t j = 0; j < 64; j += 8)
+                    {
+                        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + j));
+                        const __m256i out = _mm256_or_si256(
+                            _mm256_cmpgt_epi32(vlo, x), _mm256_cmpgt_epi32(x, vhi));
+                        const unsigned m = ~_mm256_movemask_ps(_mm256_castsi256_ps(out)) & 0xFFu;
+                        word |= static_cast<uint64_t>(m) << j;
+                    }
+                    bits[w] = word;
+                    count += bits::popcount64(word);
+                }
+                return count;
+            }
+
+            FIXEDPOINT_TARGET("avx512f,popcnt")
+            inline size_t rangeWordsAvx512(const long long* v, size_t words, long long lo, long long hi, uint64_t* bits)
+            {
+                const __m512i vlo = _mm512_set1_epi64(lo);
+                const __m512i vhi = _mm512_set1_epi64(hi);
+                size_t count = 0;
+                for (size_t w = 0; w < words; ++w, v += 64)
+                {
+                    uint64_t word = 0;
+                    for (size_t j = 0; j < 64; j += 8)
+                    {
+                        const __m512i x = _mm512_loadu_si512(v + j);
+                        const __mmask8 m = _mm512_mask_cmple_epi64_mask(_mm512_cmpge_epi64_mask(x, vlo), x, vhi);
+                        word |= static_cast<uint64_t>(m) << j;
+                    }
+                    bits[w] = word;
+                    count += bits::popcount64(word);
+                }
+                return count;
+            }
+
+            FIXEDPOINT_TARGET("avx512f,popcnt")
+            inline size_t rangeWordsAvx512(const int* v, size_t words, int lo, int hi, uint64_t* bits)
+            {
+                const __m512i vlo = _mm512_set1_epi32(lo);
+                const __m512i vhi = _mm512_set1_epi32(hi);
+                size_t count = 0;
+                for (size_t w = 0; w < words; ++w, v += 64)
+                {
+                    uint64_t word = 0;
+                    for (size_t j = 0; j < 64; j += 16)
+                    {
+                        const __m512i x = _mm512_loadu_si512(v + j);
+                        const __mmask16 m = _mm512_mask_cmple_epi32_mask(_mm512_cmpge_epi32_mask(x, vlo), x, vhi);
+                        word |= static_cast<uint64_t>(m) << j;
+                    }
+                    bits[w] = word;
+                    count += bits::popcount64(word);
+                }
+                return count;
+            }
+#endif
+
+            template <typename T>
+            struct rangeWordsImpl
+            {
+                inline static size_t f(const T* v, size_t words, T lo, T hi, uint64_t* bits)
+                {
+                    return rangeWordsScalar(v, words, lo, hi, bits);
+                }
+            };
+
+            // int and long long columns pick a kernel for the active Dispatch::Level
+            template <typename T>
+            struct rangeWordsDispatch
+            {
+                typedef size_t (*Kernel)(const T*, size_t, T, T, uint64_t*);
+
+                inline static size_t f(const T* v, size_t words, T lo, T hi, uint64_t* bits)
+                {
+#if FIXEDPOINT_X86
+                    static const Kernel kernels[Dispatch::LevelCount] =
+                        { &rangeWordsScalar<T>, &rangeWordsSse42, &rangeWordsAvx2, &rangeWordsAvx512 };
+                    return kernels[Dispatch::level()](v, words, lo, hi, bits);
+#else
+                    return rangeWordsScalar(v, words, lo, hi, bits);
+#endif
+                }
+            };
+
+            template <> struct rangeWordsImpl<int> : rangeWordsDispatch<int> { };
+            template <> struct rangeWordsImpl<long long int> : rangeWordsDispatch<long long int> { };
+
+            // Fixed<dps, T> is a single T, so a column can be read as raw values
+            template <size_t dps, typename T>
+            inline const T* raw(const Fixed<dps, T>* col)
+            {
+                static_assert(sizeof(Fixed<dps, T>) == sizeof(T), "Fixed must wrap a single value");
+                return reinterpret_cast<const T*>(col);
+            }
+
+            template <size_t dps, typename T>
+            inline T* raw(Fixed<dps, T>* col)
+            {
+                static_assert(sizeof(Fixed<dps, T>) == sizeof(T), "Fixed must wrap a single value");
+                return reinterpret_cast<T*>(col);
+            }
+        }
+    }
+
+    namespace Bulk
+    {
+        // Inclusive range of raw m_Value's selected by a predicate.
+        // Build once per constant, reuse across scans.
+        template <size_t dps, typename T = config::DefaultType>
+        struct ScanRange
+        {
+            T lo;
+            T hi;
+            bool none; // no value of T can match
+
+            static ScanRange<dps, T> empty()
+            {
+                ScanRange<dps, T> r = { T(1), T(0), true };
+                return r;
+            }
+
+            static ScanRange<dps, T> make(const details::scan::Bound& lo, const details::scan::Bound& hi)
+            {
+                using namespace details::scan;
+                if (aboveMax<T>(lo) || belowMin<T>(hi)) return empty();
+                ScanRange<dps, T> r;
+                r.lo = belowMin<T>(lo) ? std::numeric_limits<T>::min() : static_cast<T>(lo.v);
+                r.hi = aboveMax<T>(hi) ? std::numeric_limits<T>::max() : static_cast<T>(hi.v);
+                r.none = r.lo > r.hi;
+                return r;
+            }
+
+            // value > c
+            template <size_t dps2, typename T2>
+            static ScanRange<dps, T> greater(const Fixed<dps2, T2>& c)
+            {
+                const details::scan::Bound top = { 1, 0 };
+                return make(details::scan::plusOne(
+                    details::scan::threshold(c.m_Value, dps2, dps, false)), top);
+            }
+
+            // value >= c
+            template <size_t dps2, typename T2>
+            static ScanRange<dps, T> greaterEqual(const Fixed<dps2, T2>& c)
+            {
+                const details::scan::Bound top = { 1, 0 };
+                return make(details::scan::threshold(c.m_Value, dps2, dps, true), top);
+            }
+
+            // value < c
+            template <size_t dps2, typename T2>
+            static ScanRange<dps, T> less(const Fixed<dps2, T2>& c)
+            {
+                const details::scan::Bound bottom = { -1, 0 };
+                return make(bottom, details::scan::minusOne(
+                    details::scan::threshold(c.m_Value, dps2, dps, true)));
+            }
+
+            // value <= c
+            template <size_t dps2, typename T2>
+            static ScanRange<dps, T> lessEqual(const Fixed<dps2, T2>& c)
+            {
+                const details::scan::Bound bottom = { -1, 0 };
+                return make(bottom, details::scan::threshold(c.m_Value, dps2, dps, false));
+            }
+
+            // value == c
+            template <size_t dps2, typename T2>
+            static ScanRange<dps, T> equal(const Fixed<dps2, T2>& c)
+            {
+                return make(details::scan::threshold(c.m_Value, dps2, dps, true),
+                    details::scan::threshold(c.m_Value, dps2, dps, false));
+            }
+
+            // a <= value <= b
+            template <size_t dpsA, typename TA, size_t dpsB, typename TB>
+            static ScanRange<dps, T> between(const Fixed<dpsA, TA>& a, const Fixed<dpsB, TB>& b)
+            {
+                return make(details::scan::threshold(a.m_Value, dpsA, dps, true),
+                    details::scan::threshold(b.m_Value, dpsB, dps, false));
+            }
+        };
+
+        // Number of uint64_t words needed for a bitmap of n rows
+        inline size_t bitmapWords(size_t n)
+        {
+            return (n + 63) / 64;
+        }
+
+        // Writes bitmapWords(n) words to bits, returns the number of rows selected
+        template <size_t dps, typename T>
+        inline size_t scan(const Fixed<dps, T>* col, size_t n, const ScanRange<dps, T>& r, uint64_t* bits)
+        {
+            const size_t full = n / 64;
+            const size_t tail = n % 64;
+            if (r.none)
+            {
+                for (size_t w = 0; w < bitmapWords(n); ++w) bits[w] = 0;
+                return 0;
+            }
+            const T* v = details::scan::raw(col);
+            size_t count = details::scan::rangeWordsImpl<T>::f(v, full, r.lo, r.hi, bits);
+            if (tail)
+            {
+                bits[full] = details::scan::rangeWordScalar(v + full * 64, tail, r.lo, r.hi);
+                count += details::bits::popcount64(bits[full]);
+            }
+            return count;
+        }
+
+        // Writes the indices of the selected rows to sel (room for n entries),
+        // returns the number written
+        template <size_t dps, typename T>
+        inline size_t select(const Fixed<dps, T>* col, size_t n, const ScanRange<dps, T>& r, uint32_t* sel)
+        {
+            if (r.none) return 0;
+            const T* v = details::scan::raw(col);
+            size_t count = 0;
+            for (size_t base = 0; base < n; base += 64)
+            {
+                uint64_t word;
+                if (n - base >= 64) details::scan::rangeWordsImpl<T>::f(v + base, 1, r.lo, r.hi, &word);
+                else word = details::scan::rangeWordScalar(v + base, n - base, r.lo, r.hi);
+                for (; word; word &= word - 1)
+                    sel[count++] = static_cast<uint32_t>(base + details::bits::ctz64(word));
+            }
+            return count;
+        }
+
+        // Convenience scans, the constant is rescaled once per call
+
+        template <size_t dps, typename T, size_t dps2, typename T2>
+        inline size_t scanGreater(const Fixed<dps, T>* col, size_t n, const Fixed<dps2, T2>& c, uint64_t* bits)
+        {
+            return scan(col, n, ScanRange<dps, T>::greater(c), bits);
+        }
+
+        template <size_t dps, typename T, size_t dps2, typename T2>
+        inline size_t scanGreaterEqual(const Fixed<dps, T>* col, size_t n, const Fixed<dps2, T2>& c, uint64_t* bits)
+        {
+            return scan(col, n, ScanRange<dps, T>::greaterEqual(c), bits);
+        }
+
+        template <size_t dps, typename T, size_t dps2, typename T2>
+        inline size_t scanLess(const Fixed<dps, T>* col, size_t n, const Fixed<dps2, T2>& c, uint64_t* bits)
+        {
+            return scan(col, n, ScanRange<dps, T>::less(c), bits);
+        }
+
+        template <size_t dps, typename T, size_t dps2, typename T2>
+        inline size_t scanLessEqual(const Fixed<dps, T>* col, size_t n, const Fixed<dps2, T2>& c, uint64_t* bits)
+        {
+            return scan(col, n, ScanRange<dps, T>::lessEqual(c), bits);
+        }
+
+        template <size_t dps, typename T, size_t dps2, typename T2>
+        inline size_t scanEqual(const Fixed<dps, T>* col, size_t n, const Fixed<dps2, T2>& c, uint64_t* bits)
+        {
+            return scan(col, n, ScanRange<dps, T>::equal(c), bits);
+        }
+
+        template <size_t dps, typename T, size_t dpsA, typename TA, size_t dpsB, typename TB>
+        inline size_t scanBetween(const Fixed<dps, T>* col, size_t n,
+            const Fixed<dpsA, TA>& a, const Fixed<dpsB, TB>& b, uint64_t* bits)
+        {
+            return scan(col, n, ScanRange<dps, T>::between(a, b), bits);
+        }
+
+        // Bitmap helpers, all bitmaps cover n rows
+
+        inline size_t bitmapCount(const uint64_t* bits, size_t n)
+        {
+            size_t count = 0;
+            for (size_t w = 0; w < bitmapWords(n); ++w)
+                count += details::bits::popcount64(bits[w]);
+            return count;
+        }
+
+        inline void bitmapAnd(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n)
+        {
+            for (size_t w = 0; w < bitmapWords(n); ++w) out[w] = a[w] & b[w];
+        }
+
+        inline void bitmapOr(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n)
+        {
+            for (size_t w = 0; w < bitmapWords(n); ++w) out[w] = a[w] | b[w];
+        }
+
+        inline void bitmapAndNot(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n)
+        {
+            for (size_t w = 0; w < bitmapWords(n); ++w) out[w] = a[w] & ~b[w];
+        }
+
+        inline bool bitmapTest(const uint64_t* bits, size_t i)
+        {
+            return (bits[i / 64] >> (i % 64)) & 1;
+        }
+
+        // Writes the indices of the set rows to sel, returns the number written
+        inline size_t bitmapToSelection(const uint64_t* bits, size_t n, uint32_t* sel)
+        {
+            size_t count = 0;
+            for (size_t w = 0; w < bitmapWords(n); ++w)
+                for (uint64_t word = bits[w]; word; word &= word - 1)
+                    sel[count++] = static_cast<uint32_t>(w * 64 + details::bits::ctz64(word));
+            return count;
+        }
+    }
+}
+
+#endif
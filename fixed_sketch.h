@@ -0,0 +1,240 @@
+#ifndef __FIXED_SKETCH__39561827
+#define __FIXED_SKETCH__39561827
+
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <atomic>
+#include <limits>
+#include <memory>
+
+#include "fixed.h"
+#include "fixed_arith.h"
+
+// Mergeable quantile sketch over Fixed values.
+// Values are bucketed on their raw m_Value the way an HDR histogram does:
+// magnitudes below 2^precisionBits get a bucket each, larger magnitudes are
+// split into 2^(precisionBits - 1) buckets per power of two. A quantile is
+// therefore exact for small raw values and within a relative error of
+// 2^-precisionBits otherwise, using bounded memory whatever the count.
+//
+// Recording is lock free: a sketch is written by one owning thread using
+// plain relaxed loads and stores, and can be merged into another sketch by
+// any thread at any time. Use one sketch per recording thread and merge them
+// for reporting.
+namespace FixedPoint
+{
+    namespace details
+    {
+        namespace sketch
+        {
+            inline int msb64(uint64_t m)
+            {
+#if defined(__GNUC__)
+                return 63 - __builtin_clzll(m);
+#else
+                int b = 0;
+                while (m >>= 1) ++b;
+                return b;
+#endif
+            }
+
+            // Rescales a raw value from dpsIn to dpsOut, rounding half away from zero
+            inline long long int rescale(long long int v, size_t dpsIn, size_t dpsOut)
+            {
+                if (dpsIn < dpsOut) return v * arith::pow10<long long int>(dpsOut - dpsIn);
+                return arith::down(v, dpsIn - dpsOut);
+            }
+
+            inline void bump(std::atomic<uint64_t>& c, uint64_t n)
+            {
+                c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    namespace Stats
+    {
+        template <size_t dps, typename T = config::DefaultType, unsigned precisionBits = 8>
+        struct QuantileSketch
+        {
+            enum
+            {
+                valueBits = sizeof(T) * 8,
+                exact = 1 << precisionBits,           // buckets holding one magnitude each
+                perOctave = 1 << (precisionBits - 1), // buckets per power of two above that
+                bucketsPerSign = exact + (valueBits - precisionBits) * perOctave
+            };
+
+            static_assert(precisionBits >= 2 && precisionBits < sizeof(T) * 8, "precisionBits out of range");
+
+            QuantileSketch()
+                : m_Neg(new std::atomic<uint64_t>[bucketsPerSign])
+                , m_Pos(new std::atomic<uint64_t>[bucketsPerSign])
+            {
+                reset();
+            }
+
+            // Not thread safe, no recording or merging may run concurrently
+            void reset()
+            {
+                for (size_t i = 0; i < bucketsPerSign; ++i)
+                {
+                    m_Neg[i].store(0, std::memory_order_relaxed);
+                    m_Pos[i].store(0, std::memory_order_relaxed);
+                }
+                m_Count.store(0, std::memory_order_relaxed);
+                m_Min.store(std::numeric_limits<long long int>::max(), std::memory_order_relaxed);
+                m_Max.store(std::numeric_limits<long long int>::min(), std::memory_order_relaxed);
+            }
+
+            // Owning thread only
+            template <size_t dps2, typename T2>
+            inline void record(const Fixed<dps2, T2>& v, uint64_t times = 1)
+            {
+                recordRaw(static_cast<long long int>(Fixed<dps, T>(v).m_Value), times);
+            }
+
+            // Owning thread only
+            template <typename T2>
+            inline void record(const RTFixed<T2>& v, uint64_t times = 1)
+            {
+                recordRaw(static_cast<long long int>(static_cast<T>(
+                    details::sketch::rescale(static_cast<long long int>(v.m_Value), v.m_dps, dps))), times);
+            }
+
+            // Adds the contents of other, which may still be recording.
+            // The caller must own this sketch.
+            void merge(const QuantileSketch& other)
+            {
+                for (size_t i = 0; i < bucketsPerSign; ++i)
+                {
+                    details::sketch::bump(m_Neg[i], other.m_Neg[i].load(std::memory_order_relaxed));
+                    details::sketch::bump(m_Pos[i], other.m_Pos[i].load(std::memory_order_relaxed));
+                }
+                details::sketch::bump(m_Count, other.m_Count.load(std::memory_order_relaxed));
+                updateMin(other.m_Min.load(std::memory_order_relaxed));
+                updateMax(other.m_Max.load(std::memory_order_relaxed));
+            }
+
+            inline uint64_t count() const
+            {
+                return m_Count.load(std::memory_order_relaxed);
+            }
+
+            // Zero if nothing has been recorded, like quantile().
+            inline Fixed<dps, T> min() const
+            {
+                if (!count()) return Fixed<dps, T>();
+                return Utils::MkFxd<dps>(static_cast<T>(m_Min.load(std::memory_order_relaxed)));
+            }
+
+            inline Fixed<dps, T> max() const
+            {
+                if (!count()) return Fixed<dps, T>();
+                return Utils::MkFxd<dps>(static_cast<T>(m_Max.load(std::memory_order_relaxed)));
+            }
+
+            // q in [0, 1], nearest rank. Zero if nothing has been recorded.
+            Fixed<dps, T> quantile(double q) const
+            {
+                const uint64_t n = count();
+                if (!n) return Fixed<dps, T>();
+                uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(n) + 0.5);
+                if (rank < 1) rank = 1;
+                if (rank > n) rank = n;
+
+                // the extremes are tracked exactly
+                const long long int lo = m_Min.load(std::memory_order_relaxed);
+                const long long int hi = m_Max.load(std::memory_order_relaxed);
+                if (rank == 1) return Utils::MkFxd<dps>(static_cast<T>(lo));
+                if (rank == n) return Utils::MkFxd<dps>(static_cast<T>(hi));
+
+                // Midpoints are magnitudes, clamped to what fits the sign before negating
+                const uint64_t maxPos = static_cast<uint64_t>(std::numeric_limits<long long int>::max());
+                long long int v = 0;
+                uint64_t seen = 0;
+                bool found = false;
+                for (size_t i = bucketsPerSign; i-- > 0 && !found; )
+                {
+                    seen += m_Neg[i].load(std::memory_order_relaxed);
+                    if (seen >= rank)
+                    {
+                        const uint64_t m = midpoint(i);
+                        v = m > maxPos ? std::numeric_limits<long long int>::min() : -static_cast<long long int>(m);
+                        found = true;
+                    }
+                }
+                for (size_t i = 0; i < bucketsPerSign && !found; ++i)
+                {
+                    seen += m_Pos[i].load(std::memory_order_relaxed);
+                    if (seen >= rank)
+                    {
+                        const uint64_t m = midpoint(i);
+                        v = static_cast<long long int>(m > maxPos ? maxPos : m);
+                        found = true;
+                    }
+                }
+
+                if (!found || v > hi) v = hi;
+                if (v < lo) v = lo;
+                return Utils::MkFxd<dps>(static_cast<T>(v));
+            }
+
+            inline RTFixed<T> rtQuantile(double q) const
+            {
+                return RTFixed<T>(quantile(q));
+            }
+
+        private:
+            std::unique_ptr<std::atomic<uint64_t>[]> m_Neg;
+            std::unique_ptr<std::atomic<uint64_t>[]> m_Pos;
+            std::atomic<uint64_t> m_Count;
+            std::atomic<long long int> m_Min;
+            std::atomic<long long int> m_Max;
+
+            QuantileSketch(const QuantileSketch&);
+            QuantileSketch& operator=(const QuantileSketch&);
+
+            static inline size_t index(uint64_t m)
+            {
+                if (m < exact) return static_cast<size_t>(m);
+                const int shift = details::sketch::msb64(m) - static_cast<int>(precisionBits) + 1;
+                const size_t top = static_cast<size_t>(m >> shift);
+                return exact + (shift - 1) * perOctave + (top - perOctave);
+            }
+
+            // Middle of the magnitudes held by bucket i
+            static inline uint64_t midpoint(size_t i)
+            {
+                if (i < exact) return i;
+                const size_t k = i - exact;
+                const int shift = static_cast<int>(k / perOctave) + 1;
+                const uint64_t lo = static_cast<uint64_t>(k % perOctave + perOctave) << shift;
+                return lo + ((uint64_t(1) << shift) - 1) / 2;
+            }
+
+            inline void updateMin(long long int v)
+            {
+                if (v < m_Min.load(std::memory_order_relaxed)) m_Min.store(v, std::memory_order_relaxed);
+            }
+
+            inline void updateMax(long long int v)
+            {
+                if (v > m_Max.load(std::memory_order_relaxed)) m_Max.store(v, std::memory_order_relaxed);
+            }
+
+            inline void recordRaw(long long int v, uint64_t times)
+            {
+                if (v < 0)
+                    details::sketch::bump(m_Neg[index(0 - static_cast<uint64_t>(v))], times);
+                else
+                    details::sketch::bump(m_Pos[index(static_cast<uint64_t>(v))], times);
+                details::sketch::bump(m_Count, times);
+                updateMin(v);
+                updateMax(v);
+            }
+        };
+    }
+}
+
+#endif
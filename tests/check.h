@@ -0,0 +1,34 @@
+#ifndef FIXEDPOINT_TESTS_CHECK_H
+#define FIXEDPOINT_TESTS_CHECK_H
+
+#include <cstdio>
+#include "../fixed_dispatch.h"
+
+// Minimal self-checking harness shared by the tests in this directory.
+// Each test is a standalone program that exits non-zero on failure.
+// Run each one under every SIMD level, e.g.
+//
+//   for l in scalar sse42 avx2 avx512; do FIXEDPOINT_SIMD=$l ./test_scan || break; done
+//
+// Levels the CPU does not support fall back to the best one it does.
+namespace FixedPointTests
+{
+    inline int& failures()
+    {
+        static int n = 0;
+        return n;
+    }
+
+    inline int finish(const char* test)
+    {
+        const FixedPoint::Dispatch::Level l = FixedPoint::Dispatch::level();
+        std::printf("%s [%s]: %s\n", test, FixedPoint::Dispatch::name(l), failures() ? "FAILED" : "ok");
+        return failures() ? 1 : 0;
+    }
+}
+
+#define FIXEDPOINT_CHECK(cond) \
+    ((cond) ? (void)0 : (void)(++FixedPointTests::failures() <= 20 && \
+        std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond)))
+
+#endif
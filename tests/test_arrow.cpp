@@ -0,0 +1,216 @@
+// g++ -std=c++14 -O2 -Wall -Wno-deprecated-copy test_arrow.cpp -o test_arrow && ./test_arrow
+#include <climits>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "../fixed_arrow.h"
+#include "../fixed_scan.h"
+#include "check.h"
+
+using namespace FixedPoint;
+
+namespace
+{
+    // v * 10^-k rounded half away from zero, k > 0
+    long long down(long long v, int k)
+    {
+        long long f = 1;
+        for (int i = 0; i < k; ++i) f *= 10;
+        long long q = v / f;
+        const long long r = v % f;
+        if (2 * (r < 0 ? -r : r) >= f) q += v < 0 ? -1 : 1;
+        return q;
+    }
+
+    // Rows of Fixed<4, long long> through Decimal128 and back at dps 4, 6 and 2
+    void roundTrips(const std::vector<Fixed<4, long long> >& col, const uint64_t* valid)
+    {
+        const size_t n = col.size();
+        std::vector<uint8_t> buf(n * Arrow::Decimal128Bytes);
+        const Arrow::Decimal128Array a = Arrow::widen(col.data(), n, buf.data(), valid);
+        FIXEDPOINT_CHECK(a.m_Scale == 4 && a.m_Precision == Arrow::MaxPrecision && a.m_Length == n && a.m_Offset == 0);
+
+        std::vector<Fixed<4, long long> > same(n);
+        std::vector<Fixed<6, long long> > up(n);
+        std::vector<Fixed<2, long long> > downTwo(n);
+        FIXEDPOINT_CHECK(Arrow::narrow(a, same.data()) == n);
+        FIXEDPOINT_CHECK(Arrow::narrow(a, up.data()) == n);
+        FIXEDPOINT_CHECK(Arrow::narrow(a, downTwo.data()) == n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            const bool v = !valid || Bulk::bitmapTest(valid, i);
+            FIXEDPOINT_CHECK(Arrow::isValid(a, i) == v);
+            const long long raw = v ? col[i].m_Value : 0;
+            FIXEDPOINT_CHECK(same[i].m_Value == raw);
+            FIXEDPOINT_CHECK(up[i].m_Value == raw * 100);
+            FIXEDPOINT_CHECK(downTwo[i].m_Value == down(raw, 2));
+        }
+    }
+}
+
+int main()
+{
+    std::mt19937_64 g(11);
+    const size_t n = 300;
+    std::vector<Fixed<4, long long> > col(n);
+    for (size_t i = 0; i < n; ++i)
+        col[i] = Utils::MkFxd<4>(static_cast<long long>(g() % 2000000000001ULL) - 1000000000000LL);
+    col[0] = Utils::MkFxd<4>(0LL);
+    col[1] = Utils::MkFxd<4>(15LL);  // halves round away from zero
+    col[2] = Utils::MkFxd<4>(-15LL);
+    col[3] = Utils::MkFxd<4>(-50LL);
+    std::vector<uint64_t> positive(Bulk::bitmapWords(n));
+    Bulk::scanGreater(col.data(), n, Fixed<4, long long>(0LL), positive.data());
+
+    roundTrips(col, 0);
+    roundTrips(col, positive.data());
+
+    // Sign extension: negative values fill the high word with ones
+    {
+        const Fixed<0, int> m[1] = { Utils::MkFxd<0>(-2) };
+        uint8_t b[Arrow::Decimal128Bytes];
+        Arrow::widen(m, 1, b);
+        bool ones = b[0] == 0xFE;
+        for (size_t i = 1; i < sizeof b; ++i) ones = ones && b[i] == 0xFF;
+        FIXEDPOINT_CHECK(ones);
+    }
+
+    // narrow stops at the first row that does not fit, later rows untouched
+    {
+        const Fixed<2, long long> src[] = { Utils::MkFxd<2>(100LL), Utils::MkFxd<2>(-100LL),
+            Utils::MkFxd<2>(static_cast<long long>(INT_MAX) + 1), Utils::MkFxd<2>(5LL) };
+        uint8_t b[4 * Arrow::Decimal128Bytes];
+        const Arrow::Decimal128Array a = Arrow::widen(src, 4, b);
+        Fixed<2, int> out[4];
+        for (size_t i = 0; i < 4; ++i) out[i] = Utils::MkFxd<2>(7);
+        FIXEDPOINT_CHECK(Arrow::narrow(a, out) == 2);
+        FIXEDPOINT_CHECK(out[0].m_Value == 100 && out[1].m_Value == -100);
+        FIXEDPOINT_CHECK(out[2].m_Value == 7 && out[3].m_Value == 7);
+
+        // A null row is not checked, so it does not stop the copy
+        uint64_t skip = 0xB; // rows 0, 1 and 3
+        Arrow::Decimal128Array masked = Arrow::widen(src, 4, b, &skip);
+        FIXEDPOINT_CHECK(Arrow::narrow(masked, out) == 4);
+        FIXEDPOINT_CHECK(out[2].m_Value == 0 && out[3].m_Value == 5);
+
+        // Scaling up past the type stops too
+        Fixed<10, int> scaled[4];
+        FIXEDPOINT_CHECK(Arrow::narrow(a, scaled) == 0);
+    }
+
+    // Validity of a sliced array, across a word boundary
+    {
+        Arrow::Decimal128Array a = { 0, reinterpret_cast<const uint8_t*>(positive.data()), n, 0, 38, 4 };
+        const size_t offsets[] = { 3, 64, 67 };
+        for (size_t o = 0; o < sizeof(offsets) / sizeof(offsets[0]); ++o)
+        {
+            a.m_Offset = offsets[o];
+            a.m_Length = n - offsets[o] - 10;
+            std::vector<uint64_t> bits(Bulk::bitmapWords(a.m_Length));
+            const size_t nulls = Arrow::validity(a, bits.data());
+            size_t want = 0;
+            for (size_t i = 0; i < a.m_Length; ++i)
+            {
+                const bool v = Bulk::bitmapTest(positive.data(), i + a.m_Offset);
+                want += !v;
+                FIXEDPOINT_CHECK(Bulk::bitmapTest(bits.data(), i) == v);
+                FIXEDPOINT_CHECK(Arrow::isValid(a, i) == v);
+            }
+            FIXEDPOINT_CHECK(nulls == want);
+            FIXEDPOINT_CHECK(bits.back() >> 1 >> ((a.m_Length - 1) % 64) == 0);
+        }
+        a.m_Validity = 0;
+        std::vector<uint64_t> all(Bulk::bitmapWords(a.m_Length));
+        FIXEDPOINT_CHECK(Arrow::validity(a, all.data()) == 0);
+        FIXEDPOINT_CHECK(Bulk::bitmapCount(all.data(), a.m_Length) == a.m_Length);
+    }
+
+    // The C data interface: format strings, offsets and release callbacks
+    {
+        std::vector<uint8_t> buf(n * Arrow::Decimal128Bytes);
+        Arrow::Decimal128Array a = Arrow::widen(col.data(), n, buf.data(), positive.data());
+        a.m_Offset = 5;
+        a.m_Length = n - 5;
+        ArrowArray arr;
+        ArrowSchema schema;
+        Arrow::exportArray(a, &arr, &schema);
+        FIXEDPOINT_CHECK(std::strcmp(schema.format, "d:38,4") == 0);
+        FIXEDPOINT_CHECK(schema.flags == ARROW_FLAG_NULLABLE && schema.n_children == 0);
+        FIXEDPOINT_CHECK(arr.length == static_cast<int64_t>(n - 5) && arr.offset == 5 && arr.n_buffers == 2);
+        size_t nulls = 0;
+        for (size_t i = 5; i < n; ++i) nulls += !Bulk::bitmapTest(positive.data(), i);
+        FIXEDPOINT_CHECK(arr.null_count == static_cast<int64_t>(nulls));
+        FIXEDPOINT_CHECK(arr.buffers[0] == positive.data() && arr.buffers[1] == buf.data());
+
+        Arrow::Decimal128Array back;
+        FIXEDPOINT_CHECK(Arrow::importArray(&arr, &schema, back));
+        FIXEDPOINT_CHECK(back.m_Values == a.m_Values && back.m_Validity == a.m_Validity);
+        FIXEDPOINT_CHECK(back.m_Length == a.m_Length && back.m_Offset == 5);
+        FIXEDPOINT_CHECK(back.m_Precision == 38 && back.m_Scale == 4);
+        std::vector<Fixed<4, long long> > sliced(back.m_Length);
+        FIXEDPOINT_CHECK(Arrow::narrow(back, sliced.data()) == back.m_Length);
+        for (size_t i = 0; i < back.m_Length; ++i)
+            FIXEDPOINT_CHECK(sliced[i].m_Value == (Bulk::bitmapTest(positive.data(), i + 5) ? col[i + 5].m_Value : 0));
+
+        ArrowSchema other = schema;
+        other.format = "d:38,4,128";
+        FIXEDPOINT_CHECK(Arrow::importArray(&arr, &other, back) && back.m_Scale == 4);
+        const char* rejected[] = { "d:38,4,256", "d:38,4,", "d:38", "d:38,4x", "w:16", "l", "" };
+        for (size_t i = 0; i < sizeof(rejected) / sizeof(rejected[0]); ++i)
+        {
+            other.format = rejected[i];
+            FIXEDPOINT_CHECK(!Arrow::importArray(&arr, &other, back));
+        }
+
+        // A negative scale multiplies up on the way out
+        other.format = "d:20,-2";
+        FIXEDPOINT_CHECK(Arrow::importArray(&arr, &other, back) && back.m_Scale == -2);
+        std::vector<Fixed<0, long long> > units(back.m_Length);
+        FIXEDPOINT_CHECK(Arrow::narrow(back, units.data()) == back.m_Length);
+        for (size_t i = 0; i < back.m_Length; ++i)
+            FIXEDPOINT_CHECK(units[i].m_Value == (Bulk::bitmapTest(positive.data(), i + 5) ? col[i + 5].m_Value * 100 : 0));
+
+        // No nulls: the validity buffer is ignored
+        arr.null_count = 0;
+        other.format = "d:38,4";
+        FIXEDPOINT_CHECK(Arrow::importArray(&arr, &other, back) && back.m_Validity == 0);
+
+        schema.release(&schema);
+        arr.release(&arr);
+        FIXEDPOINT_CHECK(!schema.release && !arr.release);
+    }
+
+#if defined(__SIZEOF_INT128__)
+    // Zero copy views, and fixedSpan only when scale and alignment allow it
+    {
+        std::vector<Fixed<4, __int128> > wide(n);
+        for (size_t i = 0; i < n; ++i) wide[i] = Utils::MkFxd<4, __int128>(col[i].m_Value);
+        const Arrow::Decimal128Array v = Arrow::view(wide.data(), n, positive.data());
+        FIXEDPOINT_CHECK(static_cast<const void*>(v.m_Values) == static_cast<const void*>(wide.data()));
+        FIXEDPOINT_CHECK(Arrow::fixedSpan<4>(v) == wide.data());
+        FIXEDPOINT_CHECK(Arrow::fixedSpan<3>(v) == 0);
+        FIXEDPOINT_CHECK(Arrow::fixedSpan<5>(v) == 0);
+        Arrow::Decimal128Array s = v;
+        s.m_Offset = 7;
+        FIXEDPOINT_CHECK(Arrow::fixedSpan<4>(s) == wide.data() + 7);
+        s.m_Scale = -4;
+        FIXEDPOINT_CHECK(Arrow::fixedSpan<4>(s) == 0);
+
+        // widen writes the bytes a view would point at
+        std::vector<Fixed<4, __int128> > aligned(n + 1);
+        uint8_t* out = reinterpret_cast<uint8_t*>(aligned.data());
+        const Arrow::Decimal128Array w = Arrow::widen(col.data(), n, out);
+        FIXEDPOINT_CHECK(std::memcmp(out, wide.data(), n * Arrow::Decimal128Bytes) == 0);
+        FIXEDPOINT_CHECK(Arrow::fixedSpan<4>(w) == aligned.data());
+
+        // Half a value off: not aligned for __int128
+        const Arrow::Decimal128Array odd = Arrow::widen(col.data(), n, out + 8);
+        FIXEDPOINT_CHECK(Arrow::fixedSpan<4>(odd) == 0);
+        std::vector<Fixed<4, long long> > copied(n);
+        FIXEDPOINT_CHECK(Arrow::narrow(odd, copied.data()) == n);
+        FIXEDPOINT_CHECK(copied[n - 1].m_Value == col[n - 1].m_Value);
+    }
+#endif
+
+    return FixedPointTests::finish("test_arrow");
+}
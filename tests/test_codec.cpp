@@ -0,0 +1,87 @@
+// g++ -std=c++14 -O2 -Wall -Wno-deprecated-copy test_codec.cpp -o test_codec && ./test_codec
+#include <limits>
+#include <random>
+#include <vector>
+#include "../fixed_codec.h"
+#include "check.h"
+
+using namespace FixedPoint;
+
+namespace
+{
+    // Round trips single values, RTFixed values and batches, and checks that
+    // truncated buffers are rejected on both sides.
+    template <typename T>
+    void run(std::mt19937_64& g)
+    {
+        std::vector<T> vals;
+        const T edges[] = { 0, 1, -1, 63, -64, 64, -65, std::numeric_limits<T>::max(), std::numeric_limits<T>::min() };
+        vals.assign(edges, edges + sizeof(edges) / sizeof(edges[0]));
+        for (int i = 0; i < 10000; ++i)
+        {
+            const int bits = static_cast<int>(g() % (sizeof(T) * 8));
+            T v = static_cast<T>(g() & ((1ULL << bits) - 1));
+            if (g() & 1) v = static_cast<T>(0 - v);
+            vals.push_back(v);
+        }
+
+        uint8_t buf[32];
+        for (size_t i = 0; i < vals.size(); ++i)
+        {
+            const Fixed<3, T> f = Utils::MkFxd<3>(vals[i]);
+            Fixed<3, T> back;
+            const size_t k = Wire::encode(f, buf, sizeof(buf));
+            FIXEDPOINT_CHECK(k > 0 && k <= Wire::maxSize<T>());
+            FIXEDPOINT_CHECK(Wire::decode(buf, k, back) == k && back.m_Value == vals[i]);
+            FIXEDPOINT_CHECK(Wire::decode(buf, k - 1, back) == 0);
+            FIXEDPOINT_CHECK(Wire::encode(f, buf, k - 1) == 0);
+
+            for (size_t dps = 0; dps < 16; dps += 5)
+            {
+                const RTFixed<T> r = Utils::MkRTFxd(vals[i], dps);
+                RTFixed<T> rBack;
+                const size_t rk = Wire::encode(r, buf, sizeof(buf));
+                FIXEDPOINT_CHECK(rk > 0 && rk <= Wire::maxRTSize<T>());
+                FIXEDPOINT_CHECK(Wire::decode(buf, rk, rBack) == rk && rBack.m_Value == vals[i] && rBack.m_dps == dps);
+                FIXEDPOINT_CHECK(Wire::decode(buf, rk - 1, rBack) == 0);
+            }
+        }
+
+        std::vector<Fixed<3, T> > in;
+        for (size_t i = 0; i < vals.size(); ++i)
+            in.push_back(Utils::MkFxd<3>(vals[i]));
+        const size_t sizes[] = { 0, 1, 3, 4, 5, in.size() };
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+        {
+            const size_t n = sizes[s];
+            std::vector<uint8_t> out(Wire::maxBatchSize<T>(n));
+            const size_t k = Wire::encodeBatch(in.data(), n, out.data(), out.size());
+            FIXEDPOINT_CHECK(n == 0 || k > 0);
+            std::vector<Fixed<3, T> > back(n);
+            FIXEDPOINT_CHECK(Wire::decodeBatch(out.data(), k, back.data(), n) == k);
+            for (size_t i = 0; i < n; ++i)
+                FIXEDPOINT_CHECK(back[i].m_Value == in[i].m_Value);
+            if (n)
+            {
+                FIXEDPOINT_CHECK(Wire::decodeBatch(out.data(), k - 1, back.data(), n) == 0);
+                FIXEDPOINT_CHECK(Wire::encodeBatch(in.data(), n, out.data(), k - 1) == 0);
+            }
+        }
+
+        // A varint longer than any value of T is rejected
+        uint8_t bad[11];
+        for (int i = 0; i < 10; ++i) bad[i] = 0xFF;
+        bad[10] = 1;
+        Fixed<3, T> d;
+        FIXEDPOINT_CHECK(Wire::decode(bad, sizeof(bad), d) == 0);
+    }
+}
+
+int main()
+{
+    std::mt19937_64 g(1);
+    run<short>(g);
+    run<int>(g);
+    run<long long>(g);
+    return FixedPointTests::finish("test_codec");
+}
@@ -0,0 +1,205 @@
+// g++ -std=c++14 -O2 -Wall -Wno-deprecated-copy test_column.cpp -o test_column && ./test_column
+#include <algorithm>
+#include <climits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "../fixed_column.h"
+#include "check.h"
+
+using namespace FixedPoint;
+
+namespace
+{
+    long long pow10(size_t k)
+    {
+        long long f = 1;
+        while (k--) f *= 10;
+        return f;
+    }
+
+    // v / 10^k rounded half away from zero
+    long long down(long long v, size_t k)
+    {
+        const long long f = pow10(k);
+        long long q = v / f;
+        const long long r = v % f;
+        if (2 * (r < 0 ? -r : r) >= f) q += v < 0 ? -1 : 1;
+        return q;
+    }
+
+    // Sign of v * 10^-dv - c * 10^-dc, values small enough to scale exactly
+    int compare(const RTFixed<long long>& v, long long c, size_t dc)
+    {
+        const size_t d = std::max(v.m_dps, dc);
+        const long long x = v.m_Value * pow10(d - v.m_dps), y = c * pow10(d - dc);
+        return x < y ? -1 : (x > y ? 1 : 0);
+    }
+
+    // A random column in blocks of 1 to 150 rows, so most blocks start
+    // part way through a bitmap word
+    RTFixedColumn<long long> randomColumn(std::mt19937_64& g, size_t n, std::vector<RTFixed<long long> >& rows)
+    {
+        const size_t dps[] = { 0, 2, 4, 8 };
+        RTFixedColumn<long long> col;
+        rows.clear();
+        while (rows.size() < n)
+        {
+            const size_t count = std::min<size_t>(g() % 150 + 1, n - rows.size());
+            const size_t d = dps[g() % 4];
+            std::vector<long long> raw(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                raw[i] = static_cast<long long>(g() % 2000001) - 1000000;
+                rows.push_back(Utils::MkRTFxd(raw[i], d));
+            }
+            if (g() % 2)
+                col.append(raw.data(), count, d);
+            else
+                for (size_t i = 0; i < count; ++i) col.push_back(Utils::MkRTFxd(raw[i], d));
+        }
+        return col;
+    }
+
+    // A scan's bitmap and count against compare() row by row
+    template <typename Pred>
+    void checkScan(const std::vector<RTFixed<long long> >& rows, const std::vector<uint64_t>& bits, size_t count, Pred pred)
+    {
+        size_t want = 0;
+        for (size_t i = 0; i < rows.size(); ++i)
+        {
+            const bool hit = pred(rows[i]);
+            want += hit;
+            FIXEDPOINT_CHECK(Bulk::bitmapTest(bits.data(), i) == hit);
+        }
+        for (size_t i = rows.size(); i < bits.size() * 64; ++i) FIXEDPOINT_CHECK(!Bulk::bitmapTest(bits.data(), i));
+        FIXEDPOINT_CHECK(count == want);
+    }
+}
+
+int main()
+{
+    std::mt19937_64 g(13);
+    std::vector<RTFixed<long long> > rows, other;
+    const RTFixedColumn<long long> col = randomColumn(g, 20000, rows);
+    const RTFixedColumn<long long> col2 = randomColumn(g, 21000, other);
+    const size_t n = rows.size();
+
+    FIXEDPOINT_CHECK(col.size() == n);
+    size_t dpsMax = 0, blocks = 1;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const RTFixed<long long> r = col[i];
+        FIXEDPOINT_CHECK(r.m_Value == rows[i].m_Value && r.m_dps == rows[i].m_dps);
+        dpsMax = std::max(dpsMax, rows[i].m_dps);
+        if (i && rows[i].m_dps != rows[i - 1].m_dps) ++blocks;
+    }
+    FIXEDPOINT_CHECK(col.blockCount() == blocks && col.maxDps() == dpsMax);
+
+    // Sum across blocks at the largest dps
+    bool over = true;
+    const RTFixed<long long> s = Bulk::sum(col, &over);
+    long long total = 0;
+    for (size_t i = 0; i < n; ++i) total += rows[i].m_Value * pow10(dpsMax - rows[i].m_dps);
+    FIXEDPOINT_CHECK(!over && s.m_dps == dpsMax && s.m_Value == total);
+
+    // int sums are exact in long long until they pass it
+    RTFixedColumn<int> ints;
+    for (int i = 0; i < 1000; ++i) ints.push_back(Utils::MkFxd<2>(2000000000));
+    const RTFixed<long long> is = Bulk::sum(ints, &over);
+    FIXEDPOINT_CHECK(!over && is.m_dps == 2 && is.m_Value == 2000000000000LL);
+    ints.push_back(Utils::MkFxd<9>(1)); // 2e12 * 1e7 does not fit
+    Bulk::sum(ints, &over);
+    FIXEDPOINT_CHECK(over);
+
+#if defined(__SIZEOF_INT128__)
+    // long long blocks sum in __int128 and are checked against long long
+    RTFixedColumn<long long> big;
+    big.push_back(Utils::MkFxd<0>(LLONG_MAX));
+    big.push_back(Utils::MkFxd<0>(LLONG_MAX));
+    big.push_back(Utils::MkFxd<1>(-10LL));
+    Bulk::sum(big, &over);
+    FIXEDPOINT_CHECK(over);
+    RTFixedColumn<long long> back;
+    back.push_back(Utils::MkFxd<0>(LLONG_MAX));
+    back.push_back(Utils::MkFxd<0>(1LL));
+    back.push_back(Utils::MkFxd<0>(-1LL));
+    FIXEDPOINT_CHECK(Bulk::sum(back, &over).m_Value == LLONG_MAX && !over);
+#endif
+
+    // Row by row add where the two columns' blocks do not line up
+    RTFixedColumn<long long> added;
+    Bulk::add(col, col2, added);
+    FIXEDPOINT_CHECK(added.size() == n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const size_t d = std::max(rows[i].m_dps, other[i].m_dps);
+        const RTFixed<long long> r = added[i];
+        FIXEDPOINT_CHECK(r.m_dps == d);
+        FIXEDPOINT_CHECK(r.m_Value == rows[i].m_Value * pow10(d - rows[i].m_dps) + other[i].m_Value * pow10(d - other[i].m_dps));
+    }
+    RTFixedColumn<long long> shorter;
+    Bulk::add(col2, col, shorter);
+    FIXEDPOINT_CHECK(shorter.size() == n);
+
+    // int blocks as far apart as int allows
+    RTFixedColumn<int> x, y, xy;
+    x.push_back(Utils::MkFxd<0>(2));
+    x.push_back(Utils::MkFxd<9>(5));
+    y.push_back(Utils::MkFxd<9>(-7));
+    y.push_back(Utils::MkFxd<0>(-1));
+    Bulk::add(x, y, xy);
+    FIXEDPOINT_CHECK(xy.size() == 2 && xy.blockCount() == 1 && xy.block(0).m_Dps == 9);
+    FIXEDPOINT_CHECK(xy[0].m_Value == 1999999993 && xy[1].m_Value == -999999995);
+
+    // normalize scales up blocks below dps and rounds down those above it
+    std::vector<Fixed<3, long long> > three(n);
+    std::vector<Fixed<8, long long> > eight(n);
+    Bulk::normalize(col, three.data());
+    Bulk::normalize(col, eight.data());
+    for (size_t i = 0; i < n; ++i)
+    {
+        const size_t d = rows[i].m_dps;
+        const long long v = rows[i].m_Value;
+        FIXEDPOINT_CHECK(three[i].m_Value == (d <= 3 ? v * pow10(3 - d) : down(v, d - 3)));
+        FIXEDPOINT_CHECK(eight[i].m_Value == v * pow10(8 - d));
+    }
+    Fixed<0, int> units[2];
+    Bulk::normalize(x, units);
+    FIXEDPOINT_CHECK(units[0].m_Value == 2 && units[1].m_Value == 0);
+
+    // Block scans against per row comparisons. The constants sit at dps
+    // above, between and below the blocks'.
+    std::vector<uint64_t> bits(Bulk::bitmapWords(n));
+    const Fixed<3, long long> lo = Utils::MkFxd<3>(-2500LL);
+    const Fixed<1, long long> hi = Utils::MkFxd<1>(12LL);
+    const Fixed<10, long long> fine = Utils::MkFxd<10>(-12345678901LL);
+    const Fixed<2, long long> eq = Utils::MkFxd<2>(rows[77].m_dps <= 2 ? rows[77].m_Value * pow10(2 - rows[77].m_dps) : 5LL);
+    checkScan(rows, bits, Bulk::scanGreater(col, lo, bits.data()),
+        [&](const RTFixed<long long>& r) { return compare(r, lo.m_Value, 3) > 0; });
+    checkScan(rows, bits, Bulk::scanGreaterEqual(col, fine, bits.data()),
+        [&](const RTFixed<long long>& r) { return compare(r, fine.m_Value, 10) >= 0; });
+    checkScan(rows, bits, Bulk::scanLess(col, hi, bits.data()),
+        [&](const RTFixed<long long>& r) { return compare(r, hi.m_Value, 1) < 0; });
+    checkScan(rows, bits, Bulk::scanLessEqual(col, fine, bits.data()),
+        [&](const RTFixed<long long>& r) { return compare(r, fine.m_Value, 10) <= 0; });
+    checkScan(rows, bits, Bulk::scanEqual(col, eq, bits.data()),
+        [&](const RTFixed<long long>& r) { return compare(r, eq.m_Value, 2) == 0; });
+    checkScan(rows, bits, Bulk::scanBetween(col, lo, hi, bits.data()),
+        [&](const RTFixed<long long>& r) { return compare(r, lo.m_Value, 3) >= 0 && compare(r, hi.m_Value, 1) <= 0; });
+
+    // dps is checked when a block is added: below 19 and 10^dps within T
+    RTFixedColumn<int> narrowDps;
+    narrowDps.extend(1, RTFixedColumn<int>::dpsLimit);
+    bool threw = false;
+    try { narrowDps.extend(1, 10); } catch (const std::invalid_argument&) { threw = true; }
+    FIXEDPOINT_CHECK(threw && narrowDps.size() == 1);
+    RTFixedColumn<long long> wideDps;
+    wideDps.push_back(Utils::MkRTFxd(1LL, 18));
+    threw = false;
+    try { wideDps.push_back(Utils::MkRTFxd(1LL, 19)); } catch (const std::invalid_argument&) { threw = true; }
+    FIXEDPOINT_CHECK(threw && wideDps.size() == 1 && wideDps.blockCount() == 1);
+    FIXEDPOINT_CHECK(RTFixedColumn<int>::dpsLimit == 9 && RTFixedColumn<long long>::dpsLimit == 18);
+
+    return FixedPointTests::finish("test_column");
+}
@@ -0,0 +1,40 @@
+// g++ -std=c++14 -O2 -Wall test_dispatch.cpp -o test_dispatch && FIXEDPOINT_SIMD=sse42 ./test_dispatch
+#include <cstdlib>
+#include <cstring>
+#include "check.h"
+
+using namespace FixedPoint;
+
+int main()
+{
+    const Dispatch::Level best = Dispatch::detect();
+    FIXEDPOINT_CHECK(best >= Dispatch::Scalar && best < Dispatch::LevelCount);
+
+    // level() honours FIXEDPOINT_SIMD, capped at what the CPU supports
+    Dispatch::Level expected = best;
+    if (const char* env = std::getenv("FIXEDPOINT_SIMD"))
+    {
+        for (int l = Dispatch::Scalar; l < Dispatch::LevelCount; ++l)
+            if (std::strcmp(env, Dispatch::name(static_cast<Dispatch::Level>(l))) == 0 && l < best)
+                expected = static_cast<Dispatch::Level>(l);
+    }
+    const Dispatch::Level start = Dispatch::level();
+    FIXEDPOINT_CHECK(start == expected);
+    FIXEDPOINT_CHECK(Dispatch::level() == start);
+
+    for (int l = Dispatch::Scalar; l < Dispatch::LevelCount; ++l)
+    {
+        const Dispatch::Level want = static_cast<Dispatch::Level>(l);
+        const Dispatch::Level got = Dispatch::setLevel(want);
+        FIXEDPOINT_CHECK(got == (want < best ? want : best));
+        FIXEDPOINT_CHECK(Dispatch::level() == got);
+    }
+
+    FIXEDPOINT_CHECK(std::strcmp(Dispatch::name(Dispatch::Scalar), "scalar") == 0);
+    FIXEDPOINT_CHECK(std::strcmp(Dispatch::name(Dispatch::SSE42), "sse42") == 0);
+    FIXEDPOINT_CHECK(std::strcmp(Dispatch::name(Dispatch::AVX2), "avx2") == 0);
+    FIXEDPOINT_CHECK(std::strcmp(Dispatch::name(Dispatch::AVX512), "avx512") == 0);
+
+    Dispatch::setLevel(start);
+    return FixedPointTests::finish("test_dispatch");
+}
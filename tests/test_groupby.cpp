@@ -0,0 +1,117 @@
+// g++ -std=c++14 -O2 -Wall -Wno-deprecated-copy -pthread test_groupby.cpp -o test_groupby && ./test_groupby
+#include <climits>
+#include <map>
+#include <random>
+#include <vector>
+#include "../fixed_groupby.h"
+#include "../fixed_scan.h"
+#include "check.h"
+
+using namespace FixedPoint;
+
+namespace
+{
+    struct Ref
+    {
+        long long sum;
+        size_t count;
+        int min;
+        int max;
+    };
+
+    // sum / count rounded half away from zero, small sums only
+    long long mean(long long sum, long long count)
+    {
+        long long q = sum / count;
+        const long long r = sum % count;
+        if (2 * (r < 0 ? -r : r) >= count) q += sum < 0 ? -1 : 1;
+        return q;
+    }
+
+    // groupBy against a std::map built row by row, with and without a filter
+    void run(const std::vector<int>& keys, const std::vector<Fixed<2, int> >& values,
+        size_t threads, const uint64_t* filter)
+    {
+        std::map<int, Ref> ref;
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            if (filter && !((filter[i / 64] >> (i % 64)) & 1)) continue;
+            const int v = values[i].m_Value;
+            std::map<int, Ref>::iterator it = ref.find(keys[i]);
+            if (it == ref.end())
+            {
+                const Ref r = { 0, 0, v, v };
+                it = ref.insert(std::make_pair(keys[i], r)).first;
+            }
+            Ref& r = it->second;
+            r.sum += v;
+            ++r.count;
+            if (v < r.min) r.min = v;
+            if (v > r.max) r.max = v;
+        }
+
+        const std::vector<Bulk::GroupStats<2, int, int> > got =
+            Bulk::groupBy(keys.data(), values.data(), keys.size(), threads, filter);
+        FIXEDPOINT_CHECK(got.size() == ref.size());
+        if (got.size() != ref.size()) return;
+        size_t j = 0;
+        for (std::map<int, Ref>::const_iterator it = ref.begin(); it != ref.end(); ++it, ++j)
+        {
+            const Bulk::GroupStats<2, int, int>& g = got[j];
+            FIXEDPOINT_CHECK(g.key == it->first);
+            FIXEDPOINT_CHECK(g.count == it->second.count);
+            FIXEDPOINT_CHECK(g.sum.m_Value == it->second.sum);
+            FIXEDPOINT_CHECK(g.min.m_Value == it->second.min);
+            FIXEDPOINT_CHECK(g.max.m_Value == it->second.max);
+            FIXEDPOINT_CHECK(g.mean.m_Value == mean(it->second.sum, static_cast<long long>(it->second.count)));
+            FIXEDPOINT_CHECK(!g.overflow);
+        }
+    }
+}
+
+int main()
+{
+    std::mt19937_64 g(3);
+    const size_t n = 300000;
+    std::vector<int> keys(n);
+    std::vector<Fixed<2, int> > values(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        keys[i] = static_cast<int>(g() % 5000) - 100;
+        values[i] = Utils::MkFxd<2>(static_cast<int>(g() % 2000001) - 1000000);
+    }
+
+    std::vector<uint64_t> positive(Bulk::bitmapWords(n));
+    Bulk::scanGreater(values.data(), n, Fixed<0, int>(0), positive.data());
+
+    const size_t threads[] = { 1, 2, 4 };
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); ++t)
+    {
+        run(keys, values, threads[t], 0);
+        run(keys, values, threads[t], positive.data());
+    }
+
+    // Means round half away from zero on both sides
+    const int tieKeys[] = { 1, 1, 2, 2 };
+    const Fixed<2, int> ties[] = { Utils::MkFxd<2>(-1), Utils::MkFxd<2>(-2), Utils::MkFxd<2>(1), Utils::MkFxd<2>(2) };
+    const std::vector<Bulk::GroupStats<2, int, int> > tie = Bulk::groupBy(tieKeys, ties, 4, 1);
+    FIXEDPOINT_CHECK(tie.size() == 2 && tie[0].mean.m_Value == -2 && tie[1].mean.m_Value == 2);
+
+#if defined(__SIZEOF_INT128__)
+    // long long sums past the limits set the flag, the mean is still exact.
+    // Without __int128 the sums are long long and overflowing them is undefined.
+    const long long bigKeys[] = { 7, 7, 7, 8 };
+    const Fixed<2, long long> big[] = { Utils::MkFxd<2>(LLONG_MAX), Utils::MkFxd<2>(LLONG_MAX),
+        Utils::MkFxd<2>(LLONG_MAX), Utils::MkFxd<2>(LLONG_MIN) };
+    for (size_t t = 1; t <= 2; ++t)
+    {
+        const std::vector<Bulk::GroupStats<2, long long, long long> > o = Bulk::groupBy(bigKeys, big, 4, t);
+        FIXEDPOINT_CHECK(o.size() == 2);
+        if (o.size() != 2) continue;
+        FIXEDPOINT_CHECK(o[0].overflow && o[0].mean.m_Value == LLONG_MAX);
+        FIXEDPOINT_CHECK(!o[1].overflow && o[1].sum.m_Value == LLONG_MIN && o[1].mean.m_Value == LLONG_MIN);
+    }
+#endif
+
+    return FixedPointTests::finish("test_groupby");
+}
@@ -0,0 +1,189 @@
+// g++ -std=c++14 -O2 -Wall -Wno-deprecated-copy -pthread -DFIXEDPOINT_INSTRUMENT test_instrument.cpp -o test_instrument && ./test_instrument
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../fixed.h"
+#include "check.h"
+
+#if !defined(FIXEDPOINT_INSTRUMENT)
+#error "build test_instrument with -DFIXEDPOINT_INSTRUMENT"
+#endif
+
+using namespace FixedPoint;
+
+namespace
+{
+    uint64_t grandTotal(const Instrument::Snapshot& s)
+    {
+        uint64_t t = 0;
+        for (int op = 0; op < Instrument::OpCount; ++op) t += s.total(static_cast<Instrument::Op>(op));
+        return t;
+    }
+
+    // Rescales and roundings are keyed (from dps, to dps)
+    void rescales()
+    {
+        Instrument::reset();
+        const Fixed<2, long long> a = Utils::MkFxd<2>(150LL);
+        const Fixed<4, long long> up = a;
+        const Fixed<2, long long> rounded = Utils::MkFxd<4>(12345LL);
+        const Fixed<2, long long> exact = Utils::MkFxd<4>(12300LL);
+        const Fixed<2, int> sameDps = a; // a type change only, no rescale
+        (void)up; (void)rounded; (void)exact; (void)sameDps;
+
+        const Instrument::Snapshot s = Instrument::snapshot();
+        FIXEDPOINT_CHECK(s.get(Instrument::RescaleUp, 2, 4) == 1);
+        FIXEDPOINT_CHECK(s.total(Instrument::RescaleUp) == 1);
+        FIXEDPOINT_CHECK(s.get(Instrument::RescaleDown, 4, 2) == 2);
+        FIXEDPOINT_CHECK(s.get(Instrument::RoundingChanged, 4, 2) == 1);
+        FIXEDPOINT_CHECK(s.total(Instrument::Overflow) == 0);
+        FIXEDPOINT_CHECK(grandTotal(s) == 4);
+    }
+
+    // Mixed dps operators are keyed (left dps, right dps)
+    void mixed()
+    {
+        Instrument::reset();
+        const Fixed<2, long long> a = Utils::MkFxd<2>(150LL);
+        const Fixed<4, long long> b = Utils::MkFxd<4>(22500LL);
+        bool r = a == b;
+        r = a > b || r;
+        r = a < b || r;
+        (void)r;
+        const Fixed<4, long long> sum = a + b;
+        const Fixed<4, long long> diff = a - b;
+        Fixed<2, long long> acc = a;
+        acc += b;
+        acc -= b;
+        (void)sum; (void)diff;
+
+        const Instrument::Snapshot s = Instrument::snapshot();
+        FIXEDPOINT_CHECK(s.get(Instrument::EqualRescale, 2, 4) == 1);
+        FIXEDPOINT_CHECK(s.get(Instrument::GreaterRescale, 2, 4) == 1);
+        FIXEDPOINT_CHECK(s.get(Instrument::LessRescale, 2, 4) == 1);
+        FIXEDPOINT_CHECK(s.get(Instrument::AddRescale, 2, 4) == 1);
+        FIXEDPOINT_CHECK(s.get(Instrument::SubRescale, 2, 4) == 1);
+        FIXEDPOINT_CHECK(s.get(Instrument::PlusEqRescale, 2, 4) == 1);
+        FIXEDPOINT_CHECK(s.get(Instrument::MinusEqRescale, 2, 4) == 1);
+        FIXEDPOINT_CHECK(s.total(Instrument::Overflow) == 0);
+
+        // dps past MaxDps share the last slot
+        Instrument::reset();
+        const Fixed<25, long long> tiny = Utils::MkFxd<21>(1LL);
+        (void)tiny;
+        FIXEDPOINT_CHECK(Instrument::snapshot().get(Instrument::RescaleUp, 21, 25) == 1);
+        FIXEDPOINT_CHECK(Instrument::snapshot().get(Instrument::RescaleUp, Instrument::MaxDps - 1, Instrument::MaxDps - 1) == 1);
+    }
+
+    // Results that do not fit their type. short keeps the arithmetic
+    // itself defined: it is done in int and only narrowed on the way out.
+    // Fixed * Fixed is not a const member, so the operands are not const.
+    void overflows()
+    {
+        Instrument::reset();
+        Fixed<0, short> big = Utils::MkFxd<0>(static_cast<short>(30000));
+        const Fixed<4, short> up = big;                          // 3e8 raw
+        const Fixed<0, short> down = Utils::MkFxd<2>(10000000);  // 100000
+        const Fixed<2, int> narrowed = Utils::MkFxd<2>(1000000000000LL);
+        const Fixed<0, short> sum = big + big;
+        const Fixed<0, short> diff = Fixed<0, short>(Utils::MkFxd<0>(static_cast<short>(-30000))) - big;
+        const Fixed<0, short> product = big * big;
+        Fixed<0, short> acc = big;
+        acc += big;
+        acc = big;
+        acc -= Fixed<0, short>(Utils::MkFxd<0>(static_cast<short>(-30000)));
+        acc = big;
+        acc *= big;
+        (void)up; (void)down; (void)narrowed; (void)sum; (void)diff; (void)product;
+
+        const Instrument::Snapshot s = Instrument::snapshot();
+        FIXEDPOINT_CHECK(s.get(Instrument::Overflow, 0, 4) == 1);
+        FIXEDPOINT_CHECK(s.get(Instrument::Overflow, 2, 0) == 1);
+        FIXEDPOINT_CHECK(s.get(Instrument::Overflow, 2, 2) == 1);
+        FIXEDPOINT_CHECK(s.get(Instrument::Overflow, 0, 0) == 6);
+        FIXEDPOINT_CHECK(s.total(Instrument::Overflow) == 9);
+
+        // Values that fit are not counted
+        Instrument::reset();
+        Fixed<0, short> small = Utils::MkFxd<0>(static_cast<short>(100));
+        const Fixed<0, short> fine = small * small + small - small;
+        Fixed<0, short> fineAcc = small;
+        fineAcc *= small;
+        fineAcc += small;
+        fineAcc -= small;
+        const Fixed<2, short> fineUp = small;
+        (void)fine; (void)fineUp;
+        FIXEDPOINT_CHECK(Instrument::snapshot().total(Instrument::Overflow) == 0);
+    }
+
+    // Counts from live and exited threads both reach the snapshot
+    void threads()
+    {
+        Instrument::reset();
+        const size_t count = 4, each = 1000;
+        std::vector<std::thread> done;
+        for (size_t t = 0; t < count; ++t)
+            done.emplace_back([]
+            {
+                for (size_t i = 0; i < each; ++i)
+                {
+                    const Fixed<3, long long> x = Utils::MkFxd<1>(static_cast<long long>(i));
+                    (void)x;
+                }
+            });
+        for (size_t t = 0; t < done.size(); ++t) done[t].join();
+
+        std::atomic<int> stage(0);
+        std::thread live([&]
+        {
+            const Fixed<3, long long> x = Utils::MkFxd<1>(1LL);
+            (void)x;
+            stage = 1;
+            while (stage != 2) std::this_thread::yield();
+        });
+        while (stage != 1) std::this_thread::yield();
+        FIXEDPOINT_CHECK(Instrument::snapshot().get(Instrument::RescaleUp, 1, 3) == count * each + 1);
+        stage = 2;
+        live.join();
+        FIXEDPOINT_CHECK(Instrument::snapshot().get(Instrument::RescaleUp, 1, 3) == count * each + 1);
+
+        // reset() starts every thread from zero
+        Instrument::reset();
+        FIXEDPOINT_CHECK(grandTotal(Instrument::snapshot()) == 0);
+    }
+
+    // One line per non zero counter, most frequent first
+    void report()
+    {
+        Instrument::reset();
+        const Fixed<2, long long> a = Utils::MkFxd<2>(1LL);
+        for (int i = 0; i < 3; ++i)
+        {
+            const Fixed<4, long long> up = a;
+            (void)up;
+        }
+        const Fixed<1, long long> down = a;
+        (void)down;
+
+        std::ostringstream out;
+        Instrument::report(out);
+        FIXEDPOINT_CHECK(out.str() == "rescale up dps 2, 4: 3\nrescale down dps 2, 1: 1\nrounding changed value dps 2, 1: 1\n");
+
+        Instrument::reset();
+        std::ostringstream empty;
+        Instrument::report(empty);
+        FIXEDPOINT_CHECK(empty.str().empty());
+    }
+}
+
+int main()
+{
+    rescales();
+    mixed();
+    overflows();
+    threads();
+    report();
+    return FixedPointTests::finish("test_instrument");
+}
@@ -0,0 +1,144 @@
+// g++ -std=c++20 -O2 -Wall -Wno-deprecated-copy -pthread test_pipeline.cpp -o test_pipeline && ./test_pipeline
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../fixed_pipeline.h"
+#include "check.h"
+
+using namespace FixedPoint;
+
+namespace
+{
+    const char* const input = "test_pipeline_in.csv";
+    const char* const output = "test_pipeline_out.csv";
+
+    void write(const std::string& text)
+    {
+        std::ofstream f(input, std::ios::binary);
+        f << text;
+    }
+
+    std::string read()
+    {
+        std::ifstream f(output, std::ios::binary);
+        std::stringstream s;
+        s << f.rdbuf();
+        return s.str();
+    }
+
+    template <size_t dps, typename T>
+    bool parse(const std::string& text, Fixed<dps, T>& v)
+    {
+        return Pipeline::parseFixed(text.data(), text.data() + text.size(), v);
+    }
+
+    // price,qty in, price,qty,price * qty out
+    void notional(Pipeline::Batch<4, long long>& b)
+    {
+        std::vector<Fixed<4, long long> > values;
+        std::vector<size_t> offsets(1, 0);
+        for (size_t i = 0; i < b.records(); ++i)
+        {
+            Fixed<4, long long>* r = b.record(i);
+            values.push_back(r[0]);
+            values.push_back(r[1]);
+            values.push_back(r[0] * r[1]);
+            offsets.push_back(values.size());
+        }
+        b.values.swap(values);
+        b.offsets.swap(offsets);
+    }
+}
+
+int main()
+{
+    // Decimal parsing, rounding extra places half away from zero
+    Fixed<2, long long> v;
+    FIXEDPOINT_CHECK(parse(std::string("12.345"), v) && v.m_Value == 1235);
+    FIXEDPOINT_CHECK(parse(std::string(" -12.3449\r"), v) && v.m_Value == -1234);
+    FIXEDPOINT_CHECK(parse(std::string("-0.005"), v) && v.m_Value == -1);
+    FIXEDPOINT_CHECK(parse(std::string("+.5"), v) && v.m_Value == 50);
+    FIXEDPOINT_CHECK(!parse(std::string("1.2.3"), v) && !parse(std::string("-"), v) && !parse(std::string(""), v));
+    Fixed<2, int> iv;
+    FIXEDPOINT_CHECK(parse(std::string("21474836.47"), iv) && iv.m_Value == 2147483647);
+    FIXEDPOINT_CHECK(!parse(std::string("21474836.48"), iv));
+    FIXEDPOINT_CHECK(parse(std::string("-21474836.48"), iv) && iv.m_Value == -2147483647 - 1);
+    FIXEDPOINT_CHECK(!parse(std::string("21474836.475"), iv));
+
+    // Rows with CRLF and LF endings, blank and bad lines, and a last line
+    // without a newline. Output is what operator<< prints, in file order.
+    std::mt19937 g(1);
+    std::ostringstream in, want;
+    size_t records = 0, bad = 0;
+    for (int i = 0; i < 50000; ++i)
+    {
+        if (i % 5000 == 17) { in << "bad,row\n"; ++bad; continue; }
+        if (i % 7000 == 3) { in << (i % 2 ? "\r\n" : "  \n"); continue; }
+        const long long p = g() % 1000000, q = g() % 1000;
+        in << p / 10000 << '.' << std::to_string(10000 + p % 10000).substr(1) << ',' << q << (i % 3 ? "\n" : "\r\n");
+        Fixed<4, long long> price = Utils::MkFxd<4>(p), qty = Utils::MkFxd<4>(q * 10000);
+        want << price << ',' << qty << ',' << price * qty << '\n';
+        ++records;
+    }
+    in << "1.5,2";
+    Fixed<4, long long> lastPrice = Utils::MkFxd<4>(15000LL), lastQty = Utils::MkFxd<4>(20000LL);
+    want << lastPrice << ',' << lastQty << ',' << lastPrice * lastQty << '\n';
+    ++records;
+    write(in.str());
+
+    Pipeline::Options opt;
+    opt.input = input;
+    opt.output = output;
+    opt.chunkBytes = 4096;
+    opt.queueDepth = 2;
+    const size_t workers[] = { 1, 3, 8 };
+    for (size_t w : workers)
+    {
+        opt.workers = w;
+        const Pipeline::Report r = Pipeline::run<4, long long>(opt, notional);
+        FIXEDPOINT_CHECK(r.ok && r.records == records && r.errors == bad);
+        FIXEDPOINT_CHECK(r.stages[Pipeline::Parse].threads == w && r.stages[Pipeline::Format].threads == w);
+        FIXEDPOINT_CHECK(r.stages[Pipeline::Compute].threads == 1);
+        FIXEDPOINT_CHECK(r.stages[Pipeline::Parse].batches == r.stages[Pipeline::Read].batches);
+        FIXEDPOINT_CHECK(read() == want.str());
+    }
+
+    // A chunk size smaller than a line still cuts at line ends
+    opt.chunkBytes = 1;
+    opt.workers = 2;
+    write("1.25,3\r\n\n  \nx\n2");
+    Pipeline::Report small = Pipeline::run<2, long long>(opt, [](Pipeline::Batch<2, long long>&) {});
+    FIXEDPOINT_CHECK(small.ok && small.records == 2 && small.errors == 1);
+    FIXEDPOINT_CHECK(read() == "1.25,3.00\n2.00\n");
+
+    // An exception from compute stops the pipeline and is rethrown, on the
+    // first batch or a later one
+    write(in.str());
+    opt.chunkBytes = 4096;
+    for (size_t seq : { size_t(0), size_t(3) })
+    {
+        bool threw = false;
+        try
+        {
+            Pipeline::run<4, long long>(opt, [seq](Pipeline::Batch<4, long long>& b)
+            {
+                if (b.seq == seq) throw std::runtime_error("compute");
+            });
+        }
+        catch (const std::runtime_error&) { threw = true; }
+        FIXEDPOINT_CHECK(threw);
+    }
+
+    // Missing input
+    opt.input = "test_pipeline_missing.csv";
+    const Pipeline::Report missing = Pipeline::run<4, long long>(opt, notional);
+    FIXEDPOINT_CHECK(!missing.ok && missing.records == 0);
+
+    std::remove(input);
+    std::remove(output);
+    return FixedPointTests::finish("test_pipeline");
+}
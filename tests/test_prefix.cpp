@@ -0,0 +1,102 @@
+// g++ -std=c++14 -O2 -Wall -Wno-deprecated-copy -pthread test_prefix.cpp -o test_prefix && FIXEDPOINT_SIMD=avx512 ./test_prefix
+#include <climits>
+#include <random>
+#include <vector>
+#include "../fixed_prefix.h"
+#include "check.h"
+
+using namespace FixedPoint;
+
+namespace
+{
+    // All four scans against a running sum, single and multi-threaded.
+    // Sizes cover empty input and the SIMD block tails.
+    template <typename T, typename OutT>
+    void run(std::mt19937_64& g, long long range)
+    {
+        const size_t sizes[] = { 0, 1, 3, 8, 9, 1000, 100003 };
+        const size_t threads[] = { 1, 3 };
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+        {
+            const size_t n = sizes[s];
+            std::vector<Fixed<2, T> > in(n);
+            for (size_t i = 0; i < n; ++i)
+                in[i] = Utils::MkFxd<2>(static_cast<T>(static_cast<long long>(g() % (2 * range + 1)) - range));
+
+            std::vector<OutT> inclusive(n), exclusive(n);
+            OutT sum = 0;
+            for (size_t i = 0; i < n; ++i)
+            {
+                exclusive[i] = sum;
+                sum = static_cast<OutT>(sum + in[i].m_Value);
+                inclusive[i] = sum;
+            }
+
+            for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); ++t)
+            {
+                std::vector<Fixed<2, OutT> > out(n);
+                Bulk::inclusiveScan(in.data(), n, out.data(), threads[t]);
+                for (size_t i = 0; i < n; ++i)
+                    FIXEDPOINT_CHECK(out[i].m_Value == inclusive[i]);
+                Bulk::exclusiveScan(in.data(), n, out.data(), threads[t]);
+                for (size_t i = 0; i < n; ++i)
+                    FIXEDPOINT_CHECK(out[i].m_Value == exclusive[i]);
+                FIXEDPOINT_CHECK(Bulk::checkedInclusiveScan(in.data(), n, out.data(), threads[t]) == n);
+                for (size_t i = 0; i < n; ++i)
+                    FIXEDPOINT_CHECK(out[i].m_Value == inclusive[i]);
+                FIXEDPOINT_CHECK(Bulk::checkedExclusiveScan(in.data(), n, out.data(), threads[t]) == n);
+                for (size_t i = 0; i < n; ++i)
+                    FIXEDPOINT_CHECK(out[i].m_Value == exclusive[i]);
+            }
+        }
+    }
+}
+
+int main()
+{
+    std::mt19937_64 g(1);
+    run<int, long long>(g, 1000000);
+    run<long long, long long>(g, 1000000000000LL);
+    run<int, int>(g, 1000);
+    run<short, long long>(g, 30000);
+
+    // In place
+    std::vector<Fixed<2, long long> > v(100000, Utils::MkFxd<2>(3LL));
+    Bulk::inclusiveScan(v.data(), v.size(), v.data(), 3);
+    FIXEDPOINT_CHECK(v.back().m_Value == 300000);
+
+    // Checked scans report the first row whose running sum overflows
+    std::vector<Fixed<2, int> > big(100000, Utils::MkFxd<2>(100000));
+    std::vector<Fixed<2, int> > bigOut(big.size());
+    for (size_t t = 1; t <= 3; t += 2)
+        FIXEDPOINT_CHECK(Bulk::checkedInclusiveScan(big.data(), big.size(), bigOut.data(), t) == static_cast<size_t>(INT_MAX / 100000));
+
+    std::vector<Fixed<2, long long> > wide(5000, Utils::MkFxd<2>(LLONG_MAX / 1000));
+    std::vector<Fixed<2, long long> > wideOut(wide.size());
+    for (size_t t = 1; t <= 3; t += 2)
+        FIXEDPOINT_CHECK(Bulk::checkedInclusiveScan(wide.data(), wide.size(), wideOut.data(), t) == 1000);
+
+    // An exclusive row holds the total before its input, so the last input
+    // overflowing the total does not make any row overflow
+    const Fixed<2, long long> tail[2] = { Utils::MkFxd<2>(LLONG_MAX - 5), Utils::MkFxd<2>(10LL) };
+    Fixed<2, long long> tailOut[2];
+    FIXEDPOINT_CHECK(Bulk::checkedExclusiveScan(tail, 2, tailOut, 1) == 2);
+    FIXEDPOINT_CHECK(tailOut[0].m_Value == 0 && tailOut[1].m_Value == LLONG_MAX - 5);
+    FIXEDPOINT_CHECK(Bulk::checkedInclusiveScan(tail, 2, tailOut, 1) == 1);
+
+    const Fixed<2, long long> mid[3] = { Utils::MkFxd<2>(1LL), Utils::MkFxd<2>(LLONG_MAX), Utils::MkFxd<2>(-5LL) };
+    Fixed<2, long long> midOut[3];
+    FIXEDPOINT_CHECK(Bulk::checkedExclusiveScan(mid, 3, midOut, 1) == 2);
+    FIXEDPOINT_CHECK(midOut[0].m_Value == 0 && midOut[1].m_Value == 1);
+
+    // Same across a block boundary: the total first overflows at the end of row 131072
+    std::vector<Fixed<2, long long> > edge(3 << 16, Utils::MkFxd<2>(LLONG_MAX / 131072));
+    std::vector<Fixed<2, long long> > edgeOut(edge.size());
+    for (size_t t = 1; t <= 3; t += 2)
+    {
+        FIXEDPOINT_CHECK(Bulk::checkedInclusiveScan(edge.data(), edge.size(), edgeOut.data(), t) == 131072);
+        FIXEDPOINT_CHECK(Bulk::checkedExclusiveScan(edge.data(), edge.size(), edgeOut.data(), t) == 131073);
+    }
+
+    return FixedPointTests::finish("test_prefix");
+}
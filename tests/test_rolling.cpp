@@ -0,0 +1,101 @@
+// g++ -std=c++14 -O2 -Wall -Wno-deprecated-copy test_rolling.cpp -o test_rolling && ./test_rolling
+#include <deque>
+#include <random>
+#include "../fixed_rolling.h"
+#include "check.h"
+
+using namespace FixedPoint;
+
+namespace
+{
+    struct Row
+    {
+        long long time;
+        long long value;  // raw, dps 2
+        long long volume; // raw, dps 3
+    };
+
+    // num / den in the given mode, den > 0
+    long long divRound(long long num, long long den, Stats::Rounding mode)
+    {
+        long long q = num / den;
+        const long long r = num % den;
+        if (r == 0 || mode == Stats::Rounding::TowardZero) return q;
+        const long long twice = (r < 0 ? -r : r) * 2;
+        if (twice > den || (twice == den && (mode == Stats::Rounding::HalfAwayFromZero || q % 2 != 0)))
+            q += num < 0 ? -1 : 1;
+        return q;
+    }
+
+    // Mean, VWAP and variance recomputed from the rows in the window
+    template <typename Window>
+    void check(const Window& w, const std::deque<Row>& rows)
+    {
+        FIXEDPOINT_CHECK(w.size() == rows.size());
+        long long n = static_cast<long long>(rows.size()), s = 0, sw = 0, svw = 0, sq = 0;
+        for (size_t i = 0; i < rows.size(); ++i)
+        {
+            s += rows[i].value;
+            sw += rows[i].volume;
+            svw += rows[i].value * rows[i].volume;
+            sq += rows[i].value * rows[i].value;
+        }
+        const Stats::Rounding modes[] = { Stats::Rounding::HalfAwayFromZero, Stats::Rounding::HalfEven, Stats::Rounding::TowardZero };
+        for (size_t m = 0; m < 3; ++m)
+        {
+            const Stats::Rounding mode = modes[m];
+            FIXEDPOINT_CHECK(w.mean(mode).m_Value == (n ? divRound(s, n, mode) : 0));
+            FIXEDPOINT_CHECK(w.template mean<4>(mode).m_Value == (n ? divRound(s * 100, n, mode) : 0));
+            FIXEDPOINT_CHECK(w.template mean<1>(mode).m_Value == (n ? divRound(s, n * 10, mode) : 0));
+            FIXEDPOINT_CHECK(w.vwap(mode).m_Value == (sw ? divRound(sw < 0 ? -svw : svw, sw < 0 ? -sw : sw, mode) : 0));
+            FIXEDPOINT_CHECK(w.template variance<4>(mode).m_Value == (n ? divRound(n * sq - s * s, n * n, mode) : 0));
+            FIXEDPOINT_CHECK(w.variance(mode).m_Value == (n ? divRound(n * sq - s * s, n * n * 100, mode) : 0));
+        }
+    }
+}
+
+int main()
+{
+    std::mt19937_64 g(5);
+
+    // Count based: the last 50 rows, with volumes
+    Stats::RollingWindow<2, long long, 3, long long> w(50);
+    std::deque<Row> rows;
+    check(w, rows);
+    for (int i = 0; i < 5000; ++i)
+    {
+        // Small ranges make exact ties common
+        const long long range = (i % 3) ? 100000 : 7;
+        const Row r = { 0, static_cast<long long>(g() % (2 * range + 1)) - range, static_cast<long long>(g() % 5000) - 500 };
+        w.push(Utils::MkFxd<2>(r.value), Utils::MkFxd<3>(r.volume));
+        rows.push_back(r);
+        if (rows.size() > 50) rows.pop_front();
+        if (i % 97 == 0)
+        {
+            w.pop();
+            rows.pop_front();
+        }
+        check(w, rows);
+    }
+    FIXEDPOINT_CHECK(w.capacity() == 50);
+
+    // Time based: rows with time in (now - 100, now], volume 1
+    Stats::TimedRollingWindow<2, long long, 3, long long> tw(100);
+    std::deque<Row> timed;
+    long long now = -1000;
+    for (int i = 0; i < 5000; ++i)
+    {
+        now += static_cast<long long>(g() % 7) + ((i % 500 == 0) ? 150 : 0);
+        const Row r = { now, static_cast<long long>(g() % 200001) - 100000, 1000 };
+        tw.push(now, Utils::MkFxd<2>(r.value));
+        timed.push_back(r);
+        while (timed.front().time <= now - 100) timed.pop_front();
+        check(tw, timed);
+    }
+    tw.expire(now + 1000);
+    timed.clear();
+    check(tw, timed);
+    FIXEDPOINT_CHECK(tw.span() == 100);
+
+    return FixedPointTests::finish("test_rolling");
+}
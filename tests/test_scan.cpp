@@ -0,0 +1,96 @@
+// g++ -std=c++14 -O2 -Wall -Wno-deprecated-copy test_scan.cpp -o test_scan && FIXEDPOINT_SIMD=avx2 ./test_scan
+#include <random>
+#include <vector>
+#include "../fixed_scan.h"
+#include "check.h"
+
+using namespace FixedPoint;
+
+namespace
+{
+    template <typename Col, typename C>
+    void checkBits(const Col* col, size_t n, const uint64_t* bits, size_t count, bool (*pred)(const Col&, const C&, const C&),
+        const C& lo, const C& hi)
+    {
+        size_t expected = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            const bool e = pred(col[i], lo, hi);
+            expected += e;
+            FIXEDPOINT_CHECK(Bulk::bitmapTest(bits, i) == e);
+        }
+        FIXEDPOINT_CHECK(count == expected);
+        FIXEDPOINT_CHECK(Bulk::bitmapCount(bits, n) == expected);
+    }
+
+    template <typename Col, typename C> bool greater(const Col& v, const C& c, const C&) { return v > c; }
+    template <typename Col, typename C> bool greaterEqual(const Col& v, const C& c, const C&) { return v >= c; }
+    template <typename Col, typename C> bool less(const Col& v, const C& c, const C&) { return v < c; }
+    template <typename Col, typename C> bool lessEqual(const Col& v, const C& c, const C&) { return v <= c; }
+    template <typename Col, typename C> bool equal(const Col& v, const C& c, const C&) { return v == c; }
+    template <typename Col, typename C> bool between(const Col& v, const C& lo, const C& hi) { return v >= lo && v <= hi; }
+
+    // Every predicate against a plain loop over the Fixed comparison operators.
+    // Sizes cover empty input, partial words and SIMD tails; offset 1 unaligns the column.
+    template <size_t dps, typename T, size_t dps2, typename T2>
+    void run(std::mt19937_64& g, long long range)
+    {
+        typedef Fixed<dps, T> Col;
+        typedef Fixed<dps2, T2> C;
+        const size_t sizes[] = { 0, 1, 7, 63, 64, 65, 1000, 4099 };
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+        {
+            const size_t n = sizes[s];
+            std::vector<Col> data(n + 1);
+            for (size_t i = 0; i < data.size(); ++i)
+                data[i] = Utils::MkFxd<dps>(static_cast<T>(static_cast<long long>(g() % (2 * range + 1)) - range));
+            const Col* col = data.data() + 1;
+
+            std::vector<uint64_t> bits(Bulk::bitmapWords(n) + 1);
+            std::vector<uint32_t> sel(n + 1), sel2(n + 1);
+            for (int it = 0; it < 20; ++it)
+            {
+                const long long scaled = range * 100;
+                const C lo = Utils::MkFxd<dps2>(static_cast<T2>(static_cast<long long>(g() % (2 * scaled + 1)) - scaled));
+                const C hi = Utils::MkFxd<dps2>(static_cast<T2>(lo.m_Value + static_cast<T2>(g() % (scaled + 1))));
+
+                checkBits(col, n, bits.data(), Bulk::scanGreater(col, n, lo, bits.data()), &greater<Col, C>, lo, hi);
+                checkBits(col, n, bits.data(), Bulk::scanGreaterEqual(col, n, lo, bits.data()), &greaterEqual<Col, C>, lo, hi);
+                checkBits(col, n, bits.data(), Bulk::scanLess(col, n, lo, bits.data()), &less<Col, C>, lo, hi);
+                checkBits(col, n, bits.data(), Bulk::scanLessEqual(col, n, lo, bits.data()), &lessEqual<Col, C>, lo, hi);
+                checkBits(col, n, bits.data(), Bulk::scanEqual(col, n, n ? col[n / 2] : Col(), bits.data()),
+                    &equal<Col, Col>, n ? col[n / 2] : Col(), Col());
+                const size_t k = Bulk::scanBetween(col, n, lo, hi, bits.data());
+                checkBits(col, n, bits.data(), k, &between<Col, C>, lo, hi);
+
+                const size_t m = Bulk::select(col, n, Bulk::ScanRange<dps, T>::between(lo, hi), sel.data());
+                FIXEDPOINT_CHECK(m == k);
+                FIXEDPOINT_CHECK(Bulk::bitmapToSelection(bits.data(), n, sel2.data()) == m);
+                for (size_t i = 0; i < m && i < n; ++i)
+                    FIXEDPOINT_CHECK(sel[i] == sel2[i]);
+            }
+        }
+    }
+}
+
+int main()
+{
+    std::mt19937_64 g(1);
+    run<2, long long, 2, long long>(g, 1000);
+    run<2, long long, 4, long long>(g, 1000);
+    run<4, long long, 2, long long>(g, 100000);
+    run<2, int, 3, int>(g, 1000);
+    run<3, int, 1, int>(g, 100000);
+    run<2, int, 2, long long>(g, 1000);
+    run<0, int, 5, long long>(g, 10);
+    run<2, short, 2, short>(g, 100);
+
+    // Constants outside the column type saturate instead of wrapping
+    const Fixed<2, int> edge[3] = { Utils::MkFxd<2>(2147483647), Utils::MkFxd<2>(-2147483647 - 1), Utils::MkFxd<2>(0) };
+    uint64_t bits = 0;
+    FIXEDPOINT_CHECK(Bulk::scanGreater(edge, 3, Utils::MkFxd<0>(100000000000LL), &bits) == 0);
+    FIXEDPOINT_CHECK(Bulk::scanLess(edge, 3, Utils::MkFxd<0>(100000000000LL), &bits) == 3);
+    FIXEDPOINT_CHECK(Bulk::scanGreaterEqual(edge, 3, Utils::MkFxd<2>(2147483647LL), &bits) == 1 && bits == 1);
+
+    return FixedPointTests::finish("test_scan");
+}
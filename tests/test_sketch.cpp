@@ -0,0 +1,138 @@
+// g++ -std=c++14 -O2 -Wall -Wno-deprecated-copy -pthread test_sketch.cpp -o test_sketch && ./test_sketch
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include "../fixed_sketch.h"
+#include "check.h"
+
+using namespace FixedPoint;
+
+namespace
+{
+    const double qs[] = { 0.0, 0.001, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 0.999, 1.0 };
+
+    // Nearest rank in a sorted reference, as quantile() defines it
+    long long reference(const std::vector<long long>& sorted, double q)
+    {
+        size_t rank = static_cast<size_t>(q * static_cast<double>(sorted.size()) + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank > sorted.size()) rank = sorted.size();
+        return sorted[rank - 1];
+    }
+
+    // Exact below 2^precisionBits, within 2^-precisionBits relative above it
+    template <typename Sketch>
+    void check(const Sketch& s, std::vector<long long> values, unsigned precisionBits)
+    {
+        std::sort(values.begin(), values.end());
+        FIXEDPOINT_CHECK(s.count() == values.size());
+        for (size_t i = 0; i < sizeof(qs) / sizeof(qs[0]); ++i)
+        {
+            const long long want = reference(values, qs[i]);
+            const long long got = static_cast<long long>(s.quantile(qs[i]).m_Value);
+            const double bound = std::fabs(static_cast<double>(want)) / static_cast<double>(1ULL << precisionBits);
+            FIXEDPOINT_CHECK(std::fabs(static_cast<double>(got) - static_cast<double>(want)) <= bound);
+        }
+        FIXEDPOINT_CHECK(s.quantile(0).m_Value == values.front());
+        FIXEDPOINT_CHECK(s.quantile(1).m_Value == values.back());
+        FIXEDPOINT_CHECK(s.min().m_Value == values.front());
+        FIXEDPOINT_CHECK(s.max().m_Value == values.back());
+    }
+}
+
+int main()
+{
+    std::mt19937_64 g(9);
+
+    // Log-uniform magnitudes of both signs, recorded on four threads and merged
+    std::vector<std::vector<long long> > data(4);
+    std::vector<long long> all;
+    for (size_t t = 0; t < data.size(); ++t)
+        for (int i = 0; i < 50000; ++i)
+        {
+            const double x = std::exp(static_cast<double>(g() % 4000) / 100.0);
+            data[t].push_back(static_cast<long long>(x) * ((g() % 5 == 0) ? -1 : 1));
+        }
+    std::vector<std::unique_ptr<Stats::QuantileSketch<4> > > per;
+    for (size_t t = 0; t < data.size(); ++t) per.emplace_back(new Stats::QuantileSketch<4>);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < data.size(); ++t)
+        threads.emplace_back([&, t]
+        {
+            for (size_t i = 0; i < data[t].size(); ++i) per[t]->record(Utils::MkFxd<4>(data[t][i]));
+        });
+    for (size_t t = 0; t < threads.size(); ++t) threads[t].join();
+
+    Stats::QuantileSketch<4> merged, serial, empty;
+    merged.merge(empty);
+    for (size_t t = 0; t < data.size(); ++t)
+    {
+        merged.merge(*per[t]);
+        for (size_t i = 0; i < data[t].size(); ++i) serial.record(Utils::MkFxd<4>(data[t][i]));
+        all.insert(all.end(), data[t].begin(), data[t].end());
+    }
+    check(merged, all, 8);
+    for (size_t i = 0; i < sizeof(qs) / sizeof(qs[0]); ++i)
+        FIXEDPOINT_CHECK(merged.quantile(qs[i]).m_Value == serial.quantile(qs[i]).m_Value);
+
+    // Small magnitudes get a bucket each, so quantiles are exact
+    Stats::QuantileSketch<2, int, 6> small;
+    std::vector<long long> smallValues;
+    for (int i = 0; i < 10000; ++i)
+    {
+        const int v = static_cast<int>(g() % 127) - 63;
+        small.record(Utils::MkFxd<2>(v));
+        smallValues.push_back(v);
+    }
+    check(small, smallValues, 0);
+
+    // The extreme buckets. The top negative bucket's midpoint is past
+    // LLONG_MIN, so it is clamped before negating.
+    Stats::QuantileSketch<0, long long> edges;
+    std::vector<long long> edgeValues;
+    const long long extremes[] = { LLONG_MIN, LLONG_MIN, LLONG_MIN + 1, LLONG_MAX - 1, LLONG_MAX, LLONG_MAX };
+    for (size_t i = 0; i < sizeof(extremes) / sizeof(extremes[0]); ++i)
+    {
+        edges.record(Utils::MkFxd<0>(extremes[i]));
+        edgeValues.push_back(extremes[i]);
+    }
+    check(edges, edgeValues, 8);
+    FIXEDPOINT_CHECK(edges.quantile(0.3).m_Value == LLONG_MIN);
+
+    Stats::QuantileSketch<0, long long> two;
+    two.record(Utils::MkFxd<0>(LLONG_MIN));
+    two.record(Utils::MkFxd<0>(LLONG_MAX));
+    FIXEDPOINT_CHECK(two.quantile(0).m_Value == LLONG_MIN);
+    FIXEDPOINT_CHECK(two.quantile(1).m_Value == LLONG_MAX);
+
+    Stats::QuantileSketch<2, int> ints;
+    std::vector<long long> intValues;
+    for (int i = 0; i < 1000; ++i)
+    {
+        const int v = static_cast<int>(g() % 2000001) - 1000000;
+        ints.record(Utils::MkFxd<2>(v));
+        intValues.push_back(v);
+    }
+    ints.record(Utils::MkFxd<2>(INT_MAX));
+    ints.record(Utils::MkFxd<2>(INT_MIN));
+    intValues.push_back(INT_MAX);
+    intValues.push_back(INT_MIN);
+    check(ints, intValues, 8);
+
+    // RTFixed values are rescaled half away from zero on the way in
+    Stats::QuantileSketch<2, int> rt;
+    rt.record(Utils::MkRTFxd(12345, 3));
+    rt.record(Utils::MkRTFxd(-12345, 3));
+    FIXEDPOINT_CHECK(rt.max().m_Value == 1235 && rt.min().m_Value == -1235);
+
+    // Nothing recorded
+    FIXEDPOINT_CHECK(empty.count() == 0);
+    FIXEDPOINT_CHECK(empty.quantile(0.5).m_Value == 0);
+    FIXEDPOINT_CHECK(empty.min().m_Value == 0 && empty.max().m_Value == 0);
+
+    return FixedPointTests::finish("test_sketch");
+}